@@ -2,13 +2,16 @@
 #include "edge_detection.h"
 #include "output.h"
 #include "image.h"
+#include "cache.h"
+#include "screen.h"
+#include "asciicast.h"
 #include <algorithm>
+#include <filesystem>
+#include <memory>
 #include <cmath>
 #include <iostream>
 #include <vector>
 #include <opencv2/opencv.hpp>
-#include <chrono>
-#include <thread>
 
 // --- Constants ---
 namespace constants
@@ -22,18 +25,166 @@ namespace constants
 // --- End Constants ---
 
 // Main function to process an image and generate ASCII art
-// Handles loading, resizing, edge detection, text generation, and output
-void processImage(const AsciiArtParams &params)
+// Handles loading, rendering, and output
+void processImage(const AsciiArtParams &params, bool show_stats)
 {
-    // Load the image from the specified input path
-    Image img = loadImage(params.input_path);
+    // Open the caches that were requested
+    std::unique_ptr<OutputCache> output_cache;
+    std::unique_ptr<PixelCache> pixel_cache;
+    RenderCaches caches;
+    if (!params.cache_dir.empty())
+    {
+        output_cache = std::make_unique<OutputCache>(params.cache_dir, params.cache_max_bytes);
+        caches.output = output_cache.get();
+    }
+    if (!params.pixel_cache_dir.empty())
+    {
+        pixel_cache = std::make_unique<PixelCache>(params.pixel_cache_dir, params.pixel_cache_max_bytes);
+        caches.pixels = pixel_cache.get();
+    }
+
+    // Decode (only the channels the output uses), resize, detect edges and generate the ASCII text
+    std::vector<uint8_t> bytes; // Read on demand
+    std::string ascii_text;
+    // The asciicast writer and a terminal take cells; only a cache hit has to parse them back from text
+    const bool wants_grid = isAsciicastFile(params.output_path) || (params.output_path.empty() && stdoutIsTerminal());
+    CellGrid grid;
+    std::string error;
+    try
+    {
+        if (!renderImageFile(params.input_path, bytes, params, caches, ascii_text, error, wants_grid ? &grid : nullptr))
+        {
+            std::cerr << "Error: " << error << std::endl;
+            return;
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        throw std::runtime_error("Failed to load image: " + params.input_path + " - " + e.what());
+    }
+
+    // --- Output Handling ---
+    // An asciicast recording gets the image as a single frame
+    if (isAsciicastFile(params.output_path))
+    {
+        AsciicastWriter writer(params.output_path, std::filesystem::path(params.input_path).filename().string());
+        writer.addFrame(grid, std::chrono::nanoseconds(0));
+        writer.finish(std::chrono::nanoseconds(0));
+    }
+    // If an output path is specified, save the ASCII text to a file
+    else if (!params.output_path.empty())
+    {
+        saveOutputText(ascii_text, params.output_path);
+    }
+    // If no output path is specified, print the ASCII text to the console.
+    // A terminal gets the sparse encoding (blank runs skipped with the cursor, trailing blanks trimmed);
+    // pipes and redirects get the text exactly as it would be saved.
+    // Either way the whole output goes out in one write instead of through the stream buffer.
+    else if (stdoutIsTerminal())
+    {
+        std::string encoded = "\n";
+        encoded.reserve(ascii_text.size());
+        appendGridSparse(grid, encoded);
+        encoded += '\n';
+        writeStdout(encoded);
+    }
+    else
+    {
+        ascii_text.insert(ascii_text.begin(), '\n');
+        ascii_text += '\n';
+        writeStdout(ascii_text);
+    }
+
+    // Cache statistics go to stderr, so they never mix with the art on stdout
+    if (show_stats)
+    {
+        if (output_cache)
+        {
+            printCacheStats(std::cerr, "Output cache", output_cache->stats());
+        }
+        if (pixel_cache)
+        {
+            printCacheStats(std::cerr, "Pixel cache", pixel_cache->stats());
+        }
+    }
+
+    // Note: Image data is automatically freed when it goes out of scope
+}
+
+// Read a file's bytes unless they were already read ahead
+static void ensureFileBytes(const std::string &path, std::vector<uint8_t> &bytes)
+{
+    if (bytes.empty() && !readFileBytes(path, bytes))
+    {
+        throw std::runtime_error("can't read file");
+    }
+}
+
+// Render an image file, consulting the output cache, then the pixel cache, then decoding
+bool renderImageFile(const std::string &path, std::vector<uint8_t> &bytes, const AsciiArtParams &params,
+                     const RenderCaches &caches, std::string &ascii_text, std::string &error, CellGrid *grid)
+{
+    // --- Output Cache ---
+    CacheKey output_key;
+    if (caches.output != nullptr)
+    {
+        ensureFileBytes(path, bytes);
+        output_key = OutputCache::makeKey(bytes.data(), bytes.size(), params);
+        if (caches.output->lookup(output_key, ascii_text))
+        {
+            // Hit: skip decode, resize and render
+            if (grid != nullptr)
+            {
+                parseGridText(ascii_text, *grid);
+            }
+            return true;
+        }
+    }
+
+    // --- Pixel Cache / Decoding ---
+    const int channels = decodeChannelsFor(params);
+    ImageView img; // Views the decoder's buffer or the mapped cache entry; neither is copied
+    CacheKey pixel_key;
+    bool use_pixel_cache = caches.pixels != nullptr && PixelCache::makeKey(path, channels, pixel_key);
+
+    if (!use_pixel_cache || !caches.pixels->lookup(pixel_key, img))
+    {
+        ensureFileBytes(path, bytes);
+        img = loadImageFromMemory(bytes.data(), bytes.size(), channels);
+        if (use_pixel_cache)
+        {
+            caches.pixels->store(pixel_key, img);
+        }
+    }
+
+    if (!renderImage(img, params, ascii_text, error, grid))
+    {
+        return false;
+    }
+
+    if (caches.output != nullptr)
+    {
+        caches.output->store(output_key, ascii_text);
+    }
+    return true;
+}
+
+// Render a decoded image to ASCII text
+// Handles resizing, edge detection and text generation. The source is only read; when no resize is
+// needed it is rendered in place, otherwise the resized pixels are owned by this function.
+bool renderImage(const ImageView &source, const AsciiArtParams &params, std::string &ascii_text, std::string &error,
+                 CellGrid *grid)
+{
+    ImageView img = source; // The pixels being rendered: the source itself or one of the buffers below
+    Image resized;          // Owns the result of stb_image_resize2
+    cv::Mat scaled_mat;     // Owns the result of cv::resize
 
     // --- Image Resizing and Aspect Ratio Adjustment ---
     // Check if auto-fit to terminal is enabled
     if (params.auto_fit)
     {
         // Resize image to fit terminal dimensions while respecting aspect ratio
-        img = resizeImageToTerminal(img, params.aspect_ratio, true);
+        img = resizeImageToTerminal(source, params.aspect_ratio, true);
     }
     // Otherwise, apply scaling based on the scale parameter
     else
@@ -48,34 +199,34 @@ void processImage(const AsciiArtParams &params)
             // Safety bounds checking
             if (target_width > 1000 || target_height > 1000)
             {
-                std::cerr << "Error: Scaled dimensions too large. Maximum 1000x1000." << std::endl;
-                return;
+                error = "Scaled dimensions too large. Maximum 1000x1000.";
+                return false;
             }
 
             if (target_width < 10 || target_height < 10)
             {
-                std::cerr << "Error: Scaled dimensions too small. Minimum 10x10." << std::endl;
-                return;
+                error = "Scaled dimensions too small. Minimum 10x10.";
+                return false;
             }
 
-            // Create new image structure with target dimensions
-            Image scaled_img;
-            scaled_img.width = target_width;
-            scaled_img.height = target_height;
-            scaled_img.channels = img.channels;
-            scaled_img.data.resize(target_width * target_height * img.channels);
-
-            // Use OpenCV for reliable resizing
-            cv::Mat src_mat(img.height, img.width,
-                            img.channels == 3 ? CV_8UC3 : CV_8UC1, img.data.data());
-            cv::Mat dst_mat;
-
-            cv::resize(src_mat, dst_mat, cv::Size(target_width, target_height), 0, 0, cv::INTER_LINEAR);
+            // cv::resize does not weight by alpha, so let stb_image_resize2 filter images being composited
+            if (params.composite_alpha)
+            {
+                resized = resizeImageTo(source, target_width, target_height);
+                img = resized;
+            }
+            else
+            {
+                // Use OpenCV for reliable resizing
+                // The source Mat wraps the view's pixels (and stride) and the result is viewed where OpenCV put it
+                cv::Mat src_mat(source.height, source.width, CV_8UC(source.channels),
+                                const_cast<uint8_t *>(source.data), source.stride);
 
-            memcpy(scaled_img.data.data(), dst_mat.data,
-                   target_width * target_height * img.channels);
+                cv::resize(src_mat, scaled_mat, cv::Size(target_width, target_height), 0, 0, cv::INTER_LINEAR);
 
-            img = scaled_img;
+                img = ImageView(scaled_mat.data, scaled_mat.cols, scaled_mat.rows, source.channels, scaled_mat.step,
+                                source.order);
+            }
         }
     }
 
@@ -87,38 +238,47 @@ void processImage(const AsciiArtParams &params)
 
     if (params.detect_edges)
     {
-        // Call the edge detection function
-        edge_magnitudes = detectEdges(img);
+        // Call the edge detection function, compositing over the background if requested
+        edge_magnitudes = detectEdges(img, params.composite_alpha ? params.background.data() : nullptr);
         // Point the pointer to the calculated magnitudes vector
         edge_magnitudes_ptr = &edge_magnitudes;
     }
     // --- End Edge Detection ---
 
-    // Generate the ASCII text representation of the image
+    // Generate the ASCII text representation of the image into the caller's buffer
     // Pass the image data, parameters, and the optional edge magnitudes pointer
-    std::string ascii_text = generateAsciiText(img, params, edge_magnitudes_ptr);
-
-    // --- Output Handling ---
-    // If an output path is specified, save the ASCII text to a file
-    if (!params.output_path.empty())
+    if (grid != nullptr)
     {
-        saveOutputText(ascii_text, params.output_path);
+        // The caller keeps the cells too, so write the text from them rather than from a throwaway grid
+        generateCellGrid(img, params, edge_magnitudes_ptr, *grid);
+        ascii_text.clear();
+        appendGridText(*grid, ascii_text);
     }
-    // If no output path is specified, print the ASCII text to the console
     else
     {
-        std::cout << std::endl
-                  << ascii_text << std::endl;
+        generateAsciiText(img, params, edge_magnitudes_ptr, ascii_text);
     }
 
-    // Note: Image data (img.data) is automatically freed when img goes out of scope
-    // Edge magnitudes vector is also freed when edge_magnitudes goes out of scope
+    // Edge magnitudes vector is freed when edge_magnitudes goes out of scope
     // OpenCV Mat objects are automatically cleaned up by their destructors
+    return true;
+}
+
+// Determine how many channels the input should be decoded into
+// Color output needs RGB; everything else (brightness and edge modes) only reads luma.
+// Compositing additionally keeps alpha (luma + alpha or RGBA) so it can be blended per cell after resizing.
+int decodeChannelsFor(const AsciiArtParams &params)
+{
+    if (params.composite_alpha)
+    {
+        return params.color ? 4 : 2;
+    }
+    return params.color ? 3 : 1;
 }
 
 // Calculate relevant information (brightness, color, edge_magnitude) for a single pixel
 // This function processes one pixel at the given (x, y) coordinates
-PixelInfo getPixelInfo(const Image &img, int x, int y, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes)
+PixelInfo getPixelInfo(const ImageView &img, int x, int y, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes)
 {
     PixelInfo info; // Create a struct to hold pixel information
 
@@ -134,31 +294,48 @@ PixelInfo getPixelInfo(const Image &img, int x, int y, const AsciiArtParams &par
         return info;
     }
 
-    // Calculate the starting index of the pixel's data in the image vector
-    int pixel_index = (y * img.width + x) * img.channels;
-
-    // --- Data Bounds Check ---
-    // More robust check to ensure accessing pixel_index and subsequent channels
-    // does not go beyond the allocated data vector size
-    if (static_cast<size_t>(pixel_index + (img.channels > 0 ? img.channels - 1 : 0)) >= img.data.size())
-    {
-        // If index is out of bounds for the data vector, return default info
-        return info;
-    }
+    // Pointer to the pixel's data; rows are stepped by the view's stride
+    const uint8_t *px = img.pixel(x, y);
     // --- End Bounds Checks ---
 
     // Get the color components based on the number of channels
     // Safely access channels if they exist
-    uint8_t r = (img.channels >= 1) ? img.data[pixel_index] : 0;
-    uint8_t g = (img.channels >= 2) ? img.data[pixel_index + 1] : 0;
-    uint8_t b = (img.channels >= 3) ? img.data[pixel_index + 2] : 0;
+    // BGR pixels (video frames) are swizzled here, on the output grid, instead of converting whole frames
+    uint8_t r = (img.channels >= 1) ? px[img.channels >= 3 ? img.redIndex() : 0] : 0;
+    uint8_t g = (img.channels >= 2) ? px[1] : 0;
+    uint8_t b = (img.channels >= 3) ? px[img.blueIndex()] : 0;
+
+    // --- Alpha Compositing ---
+    // Blend over the background here, on the resized grid, so compositing costs no extra pass.
+    // Resizing already filtered the alpha channel premultiplied, so colors here are straight alpha.
+    if (params.composite_alpha && (img.channels == 2 || img.channels == 4))
+    {
+        info.alpha = px[img.channels - 1];
+        if (img.channels == 4)
+        {
+            r = compositeOver(r, params.background[0], info.alpha);
+            g = compositeOver(g, params.background[1], info.alpha);
+            b = compositeOver(b, params.background[2], info.alpha);
+        }
+        else
+        {
+            // Luma + alpha: blend against the background's luminance
+            uint8_t bg_gray = static_cast<uint8_t>(
+                constants::GRAYSCALE_WEIGHT_R * params.background[0] +
+                constants::GRAYSCALE_WEIGHT_G * params.background[1] +
+                constants::GRAYSCALE_WEIGHT_B * params.background[2]);
+            r = compositeOver(r, bg_gray, info.alpha);
+        }
+    }
+    // --- End Alpha Compositing ---
 
     // Calculate grayscale brightness using standard luminance weights
     // These weights are defined as constants in image.cpp (conceptually)
-    uint64_t gray = static_cast<uint64_t>(
-        constants::GRAYSCALE_WEIGHT_R * r +
-        constants::GRAYSCALE_WEIGHT_G * g +
-        constants::GRAYSCALE_WEIGHT_B * b);
+    // Images decoded as luma (1 or 2 channels) already store the brightness in their first channel
+    uint64_t gray = (img.channels < 3) ? r : static_cast<uint64_t>(
+                                                 constants::GRAYSCALE_WEIGHT_R * r +
+                                                 constants::GRAYSCALE_WEIGHT_G * g +
+                                                 constants::GRAYSCALE_WEIGHT_B * b);
 
     // --- Edge Detection Data Access ---
     // If edge detection was enabled and the edge magnitudes vector was provided
@@ -247,15 +424,40 @@ char selectAsciiChar(const PixelInfo &pixel_info, const AsciiArtParams &params)
 // Generate ASCII art as a text string
 // Iterates through each pixel of the image, calculates its info, selects a character,
 // and formats the output string, including ANSI color codes if enabled.
-std::string generateAsciiText(const Image &img, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes)
+std::string generateAsciiText(const ImageView &img, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes)
 {
     std::string ascii_text; // String to build the ASCII output
+    generateAsciiText(img, params, edge_magnitudes, ascii_text);
+    return ascii_text;
+}
+
+// Generate ASCII art into an existing string, reusing its capacity
+// Used by callers that render many images or frames with one buffer
+void generateAsciiText(const ImageView &img, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes, std::string &ascii_text)
+{
+    CellGrid grid;
+    generateCellGrid(img, params, edge_magnitudes, grid);
+
+    ascii_text.clear(); // Keep the allocation from the previous image
+    appendGridText(grid, ascii_text);
+}
+
+// Render pixels into a cell grid
+// Iterates through each pixel of the image, calculates its info and selects a character and its color.
+void generateCellGrid(const ImageView &img, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes, CellGrid &grid)
+{
     // Determine if color output should be used (requires color flag and enough image channels)
     bool use_color = params.color && img.channels >= 3;
 
+    grid.width = img.width;
+    grid.height = img.height;
+    grid.color = use_color;
+    grid.cells.resize(static_cast<size_t>(img.width) * static_cast<size_t>(img.height));
+
     // Iterate through each row (height) of the image
     for (int y = 0; y < img.height; y++)
     {
+        Cell *row = grid.row(y);
         // Iterate through each column (width) of the image
         for (int x = 0; x < img.width; x++)
         {
@@ -263,220 +465,23 @@ std::string generateAsciiText(const Image &img, const AsciiArtParams &params, co
             // Pass the edge magnitudes pointer
             PixelInfo pixel_info = getPixelInfo(img, x, y, params, edge_magnitudes);
 
-            // Select the ASCII character corresponding to this pixel's info
-            char ascii_char = selectAsciiChar(pixel_info, params);
-
-            // --- Color Formatting ---
-            if (use_color)
-            {
-                // Get the color components from the pixel info
-                uint8_t r = pixel_info.color[0];
-                uint8_t g = pixel_info.color[1];
-                uint8_t b = pixel_info.color[2];
-
-                // Append ANSI color escape code for 24-bit color (RGB)
-                // Format: \033[38;2;R;G;Bm
-                ascii_text += "\033[38;2;" + std::to_string(r) + ";" + std::to_string(g) + ";" + std::to_string(b) + "m";
-                // Append the selected ASCII character
-                ascii_text += ascii_char;
-            }
-            else
+            // Fully transparent cells show the background: a plain space without any color
+            if (pixel_info.alpha == 0)
             {
-                // If color is not enabled, just append the ASCII character
-                ascii_text += ascii_char;
+                row[x] = Cell();
+                continue;
             }
-        }
 
-        // --- Color Reset and Newline ---
-        // Reset color at the end of each line to prevent bleeding into the next line or prompt
-        if (use_color)
-        {
-            ascii_text += "\033[0m"; // ANSI reset code
+            // Select the ASCII character corresponding to this pixel's info
+            row[x].glyph = selectAsciiChar(pixel_info, params);
+
+            // --- Color ---
+            // The pixel's color becomes the cell's 24-bit foreground color
+            row[x].colored = use_color;
+            row[x].indexed = false;
+            row[x].r = static_cast<uint8_t>(pixel_info.color[0]);
+            row[x].g = static_cast<uint8_t>(pixel_info.color[1]);
+            row[x].b = static_cast<uint8_t>(pixel_info.color[2]);
         }
-
-        // Add a newline character at the end of each row to move to the next line of ASCII art
-        ascii_text += '\n';
     }
-
-    // Return the complete generated ASCII text string
-    return ascii_text;
-}
-
-// --- Video Processing Implementation ---
-
-// Convert OpenCV Mat to your Image structure
-Image matToImage(const cv::Mat &mat)
-{
-    Image img;
-
-    // Set basic image properties
-    img.width = mat.cols;
-    img.height = mat.rows;
-    img.channels = mat.channels();
-
-    // Calculate total data size
-    size_t data_size = img.width * img.height * img.channels;
-    img.data.resize(data_size);
-
-    // Copy pixel data from OpenCV Mat to your Image structure
-    // OpenCV uses BGR format, so we need to convert to RGB
-    if (img.channels == 3)
-    {
-        cv::Mat rgb_mat;
-        cv::cvtColor(mat, rgb_mat, cv::COLOR_BGR2RGB);
-        memcpy(img.data.data(), rgb_mat.data, data_size);
-    }
-    else
-    {
-        // For grayscale or other formats, copy directly
-        memcpy(img.data.data(), mat.data, data_size);
-    }
-
-    return img;
 }
-
-// Check if file is a supported video/GIF format
-// Supports common video formats and animated GIFs
-bool isVideoFile(const std::string &filename)
-{
-    // Convert filename to lowercase for case-insensitive comparison
-    std::string lower = filename;
-    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-
-    // Check for supported video and GIF extensions
-    return (lower.find(".mp4") != std::string::npos ||
-            lower.find(".avi") != std::string::npos ||
-            lower.find(".mov") != std::string::npos ||
-            lower.find(".mkv") != std::string::npos ||
-            lower.find(".webm") != std::string::npos ||
-            lower.find(".gif") != std::string::npos ||
-            lower.find(".m4v") != std::string::npos ||
-            lower.find(".wmv") != std::string::npos ||
-            lower.find(".flv") != std::string::npos);
-}
-
-// Process video/GIF file with smooth playback and proper frame buffer management
-bool processVideo(const std::string &videoFile,
-                  const AsciiArtParams &params,
-                  int frameDelay)
-{
-    cv::VideoCapture cap(videoFile);
-    if (!cap.isOpened())
-    {
-        std::cerr << "Failed to open video/GIF file: " << videoFile << std::endl;
-        return false;
-    }
-
-    double fps = cap.get(cv::CAP_PROP_FPS);
-    int calculatedDelay = (fps > 0) ? static_cast<int>(1000.0 / fps) : 100;
-    int actualDelay = (frameDelay == 100) ? calculatedDelay : frameDelay;
-
-    // Terminal initialization
-    std::cout << "\033c" << std::flush;                     // Full reset
-    std::cout << "\033[?1049h" << std::flush;               // Enter alternate screen
-    std::cout << "\033[2J\033[1;1H\033[?25l" << std::flush; // Clear screen, position cursor, hide cursor
-    std::cout << "\033[?1000h" << std::flush;               // Capture mouse event
-
-    int frameCount = 0;
-    cv::Mat frame;
-    auto lastFrameTime = std::chrono::steady_clock::now();
-    int prevHeight = 0;
-    int prevWidth = 0;
-
-    while (true)
-    {
-        cap >> frame;
-        if (frame.empty())
-        {
-            break;
-        }
-
-        // Convert and process frame
-        Image img = matToImage(frame);
-
-        // Apply existing processing pipeline
-        if (params.auto_fit)
-        {
-            img = resizeImageToTerminal(img, params.aspect_ratio, true);
-        }
-        else if (params.scale != 1.0f)
-        {
-            img = resizeImage(img, params.scale, params.aspect_ratio);
-        }
-        else
-        {
-            img = resizeImage(img, 1.0f, params.aspect_ratio);
-        }
-
-        // Edge detection if enabled
-        std::vector<float> edge_magnitudes;
-        const std::vector<float> *edge_magnitudes_ptr = nullptr;
-
-        if (params.detect_edges)
-        {
-            edge_magnitudes = detectEdges(img);
-            edge_magnitudes_ptr = &edge_magnitudes;
-        }
-
-        // Generate ASCII text
-        std::string ascii_text = generateAsciiText(img, params, edge_magnitudes_ptr);
-
-        int currentHeight = img.height;
-        int currentWidth = img.width;
-
-        // Frame rendering with cleanup
-        std::cout << "\033[1;1H" << std::flush; // Go to top-left
-
-        // Clean up previous frame artifacts
-        if (prevHeight > 0 || prevWidth > 0)
-        {
-            // Clear extra lines if frame got shorter
-            if (currentHeight < prevHeight)
-            {
-                for (int i = currentHeight + 1; i <= prevHeight; i++)
-                {
-                    std::cout << "\033[" << i << ";1H\033[K";
-                }
-            }
-
-            // Clear extra columns if frame got narrower
-            if (currentWidth < prevWidth)
-            {
-                int maxHeight = std::max(currentHeight, prevHeight);
-                for (int line = 1; line <= maxHeight; line++)
-                {
-                    std::cout << "\033[" << line << ";" << (currentWidth + 1) << "H\033[K";
-                }
-            }
-
-            std::cout << "\033[1;1H";
-        }
-
-        // Display the frame
-        std::cout << ascii_text << std::flush;
-
-        // Update dimensions for next iteration
-        prevHeight = currentHeight;
-        prevWidth = currentWidth;
-        frameCount++;
-
-        // Timing control
-        auto currentTime = std::chrono::steady_clock::now();
-        auto elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - lastFrameTime).count();
-
-        if (elapsedTime < actualDelay)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(actualDelay - elapsedTime));
-        }
-
-        lastFrameTime = std::chrono::steady_clock::now();
-    }
-
-    // Restore and exit
-    std::cout << "\033[?1000l" << std::flush; // Disable mouse capture
-    std::cout << "\033[?25h" << std::flush;   // Show cursor
-    std::cout << "\033[?1049l" << std::flush; // Exit alternate screen
-
-    cap.release();
-    return true;
-}
\ No newline at end of file
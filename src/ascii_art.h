@@ -1,10 +1,11 @@
 #pragma once
 
 #include "image.h"
+#include <chrono>
 #include <string>
 #include <vector>
+#include <array>
 #include <cstdint>
-#include <opencv2/opencv.hpp>
 
 // Structure to hold parameters for ASCII art generation
 struct AsciiArtParams
@@ -19,6 +20,22 @@ struct AsciiArtParams
     bool detect_edges = false;              // Use edge magnitude instead of brightness
     float aspect_ratio = 2.0f;              // Aspect ratio of ASCII characters (width / height)
     bool auto_fit = true;                   // Automatically resize to fit terminal
+    bool composite_alpha = false;           // Blend transparent pixels over 'background' instead of ignoring alpha
+    std::array<uint8_t, 3> background = {0, 0, 0}; // RGB background color used when composite_alpha is set
+    std::string cache_dir;                  // Output cache directory (empty disables the cache)
+    uint64_t cache_max_bytes = 256ull << 20; // Output cache size limit
+    std::string pixel_cache_dir;            // Decoded-pixel cache directory (empty disables the cache)
+    uint64_t pixel_cache_max_bytes = 1024ull << 20; // Decoded-pixel cache size limit
+};
+
+class OutputCache;
+class PixelCache;
+
+// Caches consulted while rendering an image file; either may be null
+struct RenderCaches
+{
+    OutputCache *output = nullptr; // Rendered text, keyed by input bytes and settings
+    PixelCache *pixels = nullptr;  // Decoded pixels, keyed by path, modification time and size
 };
 
 // Information about a single pixel for character selection
@@ -27,20 +44,120 @@ struct PixelInfo
     uint64_t brightness = 0;                 // Grayscale brightness value of the pixel
     float edge_magnitude = 0.0f;             // Edge magnitude if edge detection is enabled
     std::vector<uint64_t> color = {0, 0, 0}; // RGB color values of the pixel
+    uint8_t alpha = 255;                     // Pixel coverage; 0 marks a fully transparent cell
+};
+
+// One character cell of rendered output
+struct Cell
+{
+    char glyph = ' ';
+    bool colored = false; // Drawn with its own 24-bit foreground color; otherwise the terminal's default
+    bool indexed = false; // The color is an entry of the 256-color palette and is sent as one (fewer bytes)
+    uint8_t r = 0, g = 0, b = 0;
+
+    // True if the two cells look the same on a terminal.
+    // Only foreground colors are ever set, so blanks look the same whatever their color.
+    bool looksLike(const Cell &other) const
+    {
+        if (glyph != other.glyph)
+        {
+            return false;
+        }
+        if (glyph == ' ')
+        {
+            return true;
+        }
+        return colored == other.colored && (!colored || (r == other.r && g == other.g && b == other.b));
+    }
+};
+
+// Rendered output as a grid of cells, row by row.
+// Video playback keeps the previous frame's grid so only the cells that changed are sent to the terminal.
+struct CellGrid
+{
+    int width = 0;           // Cells per row
+    int height = 0;          // Rows
+    bool color = false;      // Color output: rows end with a color reset in text form
+    std::vector<Cell> cells; // width * height cells, row-major
+
+    const Cell *row(int y) const { return cells.data() + static_cast<size_t>(y) * static_cast<size_t>(width); }
+    Cell *row(int y) { return cells.data() + static_cast<size_t>(y) * static_cast<size_t>(width); }
+};
+
+// Destination of the frames of a headless export (a recording file rather than the terminal).
+// Video frames arrive in order, as fast as they are rendered; a still image is one frame.
+class FrameSink
+{
+public:
+    virtual ~FrameSink() = default;
+
+    // Take one frame
+    // frame: The rendered cells (only valid during the call)
+    // pts: Presentation time relative to the first frame
+    // Throws: std::runtime_error if the frame can't be written
+    virtual void addFrame(const CellGrid &frame, std::chrono::nanoseconds pts) = 0;
+
+    // Complete the output after the last frame
+    // duration: End of the last frame (its presentation time plus one frame period)
+    // Throws: std::runtime_error if the output can't be completed
+    virtual void finish(std::chrono::nanoseconds duration) = 0;
 };
 
 // --- Function Declarations ---
 
 // Process an image based on provided parameters and generate ASCII art output
 // params: Configuration parameters for the ASCII art generation
-void processImage(const AsciiArtParams &params);
+// show_stats: Print the hits and misses of the caches in use on stderr afterwards
+void processImage(const AsciiArtParams &params, bool show_stats = false);
+
+// Determine how many channels the input should be decoded into for the given parameters
+// Monochrome output only needs luma (1); color output needs RGB (3).
+// Alpha compositing keeps an alpha channel on top of those (2 or 4).
+// params: Configuration parameters
+// Returns: The desired channel count to pass to loadImage
+int decodeChannelsFor(const AsciiArtParams &params);
+
+// Render an image file, consulting the caches first
+// An output cache hit skips decoding, resizing and rendering; a pixel cache hit skips decoding. Misses are stored.
+// path: The image file
+// bytes: The file contents if already read (e.g. read ahead), or empty to read them only when needed
+// params: Configuration parameters
+// caches: Caches to consult
+// ascii_text: Receives the generated ASCII art (its capacity is reused)
+// error: Receives the reason when rendering fails (nothing is printed, so callers can name the file)
+// grid: If given, also receives the art as cells (rendered directly, or parsed from the text on a cache hit)
+// Returns: true on success, false if rendering failed
+// Throws: std::runtime_error if the file can't be read or decoded
+bool renderImageFile(const std::string &path, std::vector<uint8_t> &bytes, const AsciiArtParams &params,
+                     const RenderCaches &caches, std::string &ascii_text, std::string &error, CellGrid *grid = nullptr);
+
+// Render a decoded image to ASCII text: resize (auto-fit or scale), detect edges if requested, and generate text
+// img: The decoded pixels (only read; rendered in place when no resize is needed)
+// params: Configuration parameters
+// ascii_text: Receives the generated ASCII art (its capacity is reused)
+// error: Receives the reason when rendering fails
+// grid: If given, receives the cells the text was written from
+// Returns: true on success, false if the requested output dimensions are out of bounds
+bool renderImage(const ImageView &img, const AsciiArtParams &params, std::string &ascii_text, std::string &error,
+                 CellGrid *grid = nullptr);
 
 // Generate ASCII art as a string based on the processed image and parameters
-// img: The Image struct containing pixel data
+// img: The pixels to render (an Image converts implicitly)
 // params: Configuration parameters
 // edge_magnitudes: Optional pointer to a vector of pre-calculated edge magnitudes (used if params.detect_edges is true)
 // Returns: A string containing the generated ASCII art
-std::string generateAsciiText(const Image &img, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes);
+std::string generateAsciiText(const ImageView &img, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes);
+
+// Generate ASCII art into an existing string, reusing its capacity across calls
+// ascii_text: Cleared and filled with the generated ASCII art
+void generateAsciiText(const ImageView &img, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes, std::string &ascii_text);
+
+// Render pixels into a cell grid (the same glyphs and colors generateAsciiText writes as text)
+// img: The pixels to render
+// params: Configuration parameters
+// edge_magnitudes: Optional pointer to pre-calculated edge magnitudes (used if params.detect_edges is true)
+// grid: Resized to the image and filled; its allocation is reused across calls
+void generateCellGrid(const ImageView &img, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes, CellGrid &grid);
 
 // Calculate relevant information (brightness, color, edge_magnitude) for a single pixel
 // img: The source image
@@ -48,27 +165,10 @@ std::string generateAsciiText(const Image &img, const AsciiArtParams &params, co
 // params: Configuration parameters
 // edge_magnitudes: Optional pointer to edge magnitudes
 // Returns: A PixelInfo struct containing the calculated information for the pixel
-PixelInfo getPixelInfo(const Image &img, int x, int y, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes);
+PixelInfo getPixelInfo(const ImageView &img, int x, int y, const AsciiArtParams &params, const std::vector<float> *edge_magnitudes);
 
 // Select an ASCII character from the character set based on the pixel information (brightness or edge magnitude)
 // pixel_info: Information about the pixel
 // params: Configuration parameters (chars, invert_color)
 // Returns: The selected ASCII character
 char selectAsciiChar(const PixelInfo &pixel_info, const AsciiArtParams &params);
-
-// Process video/GIF frame by frame using existing ASCII art pipeline
-// videoFile: Path to video/GIF
-// params: ASCII art parameters (same as used for static images)
-// frameDelay: Delay between frames in milliseconds for animation effect
-// Returns: true if processing successful, false otherwise
-bool processVideo(const std::string &videoFile, const AsciiArtParams &params, int frameDelay = 100);
-
-// Check if file is a supported video/GIF format
-// filename: Input file path to check
-// Returns: true if file extension matches supported video/GIF formats, false otherwise
-bool isVideoFile(const std::string &filename);
-
-// Convert OpenCV Mat to your Image structure for compatibility with existing pipeline
-// mat: OpenCV Mat object containing frame data
-// Returns: Image structure compatible with your existing ASCII art functions
-Image matToImage(const cv::Mat &mat);
\ No newline at end of file
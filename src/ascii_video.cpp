@@ -0,0 +1,313 @@
+#include "ascii_video.h"
+#include "output.h"
+#include "screen.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+// --- Constants ---
+namespace constants
+{
+    // Magic at the start of recorded ASCII videos (includes the format version)
+    const char ASCII_VIDEO_MAGIC[8] = {'P', 'X', 'C', 'V', 'I', 'D', '0', '1'};
+    // File extension of recorded ASCII videos
+    const char ASCII_VIDEO_EXTENSION[] = ".pxv";
+    // Frames between regular keyframes: seeking sends at most this many deltas after the keyframe
+    const uint32_t ASCII_VIDEO_KEYFRAME_INTERVAL = 60;
+    // Longest wait for the terminal to answer the synchronized-update query
+    const int ASCII_VIDEO_SYNC_QUERY_TIMEOUT_MS = 200;
+    // Frames that are due together are sent in writes of at most about this size; the rest follow straight away
+    const size_t ASCII_VIDEO_MAX_BATCH_BYTES = 1 << 20;
+}
+// --- End Constants ---
+
+using Clock = std::chrono::steady_clock;
+
+// --- Writer ---
+
+// The header is written first with no index, so an interrupted export is recognizably incomplete
+AsciiVideoWriter::AsciiVideoWriter(const std::string &path) : path(path), file(path, std::ios::binary | std::ios::trunc)
+{
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open output file for writing: " + path);
+    }
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, constants::ASCII_VIDEO_MAGIC, sizeof(header.magic));
+    header.keyframe_interval = constants::ASCII_VIDEO_KEYFRAME_INTERVAL;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    offset = sizeof(header);
+}
+
+// Keyframes start from a cleared screen, so they show correctly whatever was on the terminal before
+void AsciiVideoWriter::addFrame(const CellGrid &frame, std::chrono::nanoseconds pts)
+{
+    const uint32_t number = static_cast<uint32_t>(index.size());
+    const bool keyframe = index.empty() || frame.width != previous.width || frame.height != previous.height ||
+                          number - last_keyframe >= constants::ASCII_VIDEO_KEYFRAME_INTERVAL;
+    bytes.clear();
+    if (keyframe)
+    {
+        bytes += "\033[2J\033[1;1H";
+        appendGridSparse(frame, bytes);
+        last_keyframe = number;
+    }
+    else
+    {
+        appendGridDelta(previous, frame, bytes);
+    }
+
+    if (index.empty())
+    {
+        header.width = static_cast<uint32_t>(frame.width);
+        header.height = static_cast<uint32_t>(frame.height);
+        header.flags = frame.color ? ASCII_VIDEO_FLAG_COLOR : 0;
+    }
+    index.push_back(AsciiVideoIndexEntry{offset, static_cast<uint32_t>(bytes.size()), last_keyframe,
+                                         static_cast<int64_t>(pts.count())});
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write ASCII video: " + path);
+    }
+    offset += bytes.size();
+    previous = frame; // Same size from frame to frame, so this reuses previous's allocation
+}
+
+void AsciiVideoWriter::finish(std::chrono::nanoseconds duration)
+{
+    // The index is read in place from the mapping, so it starts 8-byte aligned
+    const char padding[8] = {};
+    const size_t pad = (8 - offset % 8) % 8;
+    file.write(padding, static_cast<std::streamsize>(pad));
+    offset += pad;
+    file.write(reinterpret_cast<const char *>(index.data()),
+               static_cast<std::streamsize>(index.size() * sizeof(AsciiVideoIndexEntry)));
+    header.frame_count = index.size();
+    header.index_offset = offset;
+    header.duration_ns = static_cast<int64_t>(duration.count());
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.close();
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write ASCII video: " + path);
+    }
+}
+
+// --- Reader ---
+
+// Map the file and check the header and every index entry up front, so playback can trust them
+AsciiVideoReader::AsciiVideoReader(const std::string &path)
+{
+    ReadOnlyFile file;
+    if (!readOnlyFile(path, file))
+    {
+        throw std::runtime_error("Failed to open ASCII video: " + path);
+    }
+    if (file.size < sizeof(AsciiVideoHeader))
+    {
+        throw std::runtime_error("Not a pixcii ASCII video (too short): " + path);
+    }
+    const size_t file_size = file.size;
+    mapping = file.data;
+
+    base = file.bytes();
+    head = reinterpret_cast<const AsciiVideoHeader *>(base);
+    if (std::memcmp(head->magic, constants::ASCII_VIDEO_MAGIC, sizeof(head->magic)) != 0)
+    {
+        throw std::runtime_error("Not a pixcii ASCII video: " + path);
+    }
+    if (head->index_offset < sizeof(AsciiVideoHeader) || head->index_offset > file_size ||
+        head->frame_count > (file_size - head->index_offset) / sizeof(AsciiVideoIndexEntry))
+    {
+        throw std::runtime_error("ASCII video is incomplete or damaged (no valid frame index): " + path);
+    }
+    entries = reinterpret_cast<const AsciiVideoIndexEntry *>(base + head->index_offset);
+    for (size_t i = 0; i < head->frame_count; i++)
+    {
+        const AsciiVideoIndexEntry &e = entries[i];
+        if (e.offset < sizeof(AsciiVideoHeader) || e.offset + e.size > head->index_offset || e.keyframe > i ||
+            entries[e.keyframe].keyframe != e.keyframe || (i > 0 && e.pts_ns < entries[i - 1].pts_ns))
+        {
+            throw std::runtime_error("ASCII video has a damaged frame index (frame " + std::to_string(i) + "): " + path);
+        }
+    }
+}
+
+size_t AsciiVideoReader::frameAt(std::chrono::nanoseconds pts) const
+{
+    const AsciiVideoIndexEntry *end = entries + head->frame_count;
+    const AsciiVideoIndexEntry *found = std::lower_bound(
+        entries, end, static_cast<int64_t>(pts.count()),
+        [](const AsciiVideoIndexEntry &e, int64_t value) { return e.pts_ns < value; });
+    return static_cast<size_t>(found - entries);
+}
+
+void AsciiVideoReader::appendSeek(size_t frame, std::string &out) const
+{
+    for (size_t i = entries[frame].keyframe; i <= frame; i++)
+    {
+        out.append(frameData(i), entries[i].size);
+    }
+}
+
+// --- Playback ---
+
+// Check the extension, case-insensitively
+bool isAsciiVideoFile(const std::string &filename)
+{
+    const size_t length = sizeof(constants::ASCII_VIDEO_EXTENSION) - 1;
+    if (filename.size() < length)
+    {
+        return false;
+    }
+    std::string extension = filename.substr(filename.size() - length);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == constants::ASCII_VIDEO_EXTENSION;
+}
+
+// Stream stored frames at their presentation times. Deltas can't be skipped (each builds on the one
+// before), so when several frames are due at once the terminal is brought to the newest of them either
+// by sending the deltas in between or by seeking (its keyframe and the deltas after it), whichever is shorter.
+bool playAsciiVideo(const std::string &path, const VideoOptions &options)
+{
+    std::unique_ptr<AsciiVideoReader> video;
+    try
+    {
+        video = std::make_unique<AsciiVideoReader>(path);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+    const size_t count = video->frameCount();
+    const size_t first = video->frameAt(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(std::max(options.start_seconds, 0.0))));
+    if (first >= count)
+    {
+        std::cerr << "Error: The start time is past the end of the video (" << std::fixed << std::setprecision(2)
+                  << static_cast<double>(video->header().duration_ns) / 1e9 << "s)." << std::endl;
+        return false;
+    }
+
+    // A fixed delay replaces the recorded timestamps; -d 0 sends frames one per write as fast as they go out
+    const bool fixed_delay = options.frame_delay != VideoOptions::AUTO_DELAY;
+    const bool unpaced = fixed_delay && options.frame_delay == 0;
+    auto pts = [&](size_t frame) {
+        if (fixed_delay)
+        {
+            return std::chrono::nanoseconds(std::chrono::milliseconds(options.frame_delay)) * static_cast<int64_t>(frame);
+        }
+        return std::chrono::nanoseconds(video->entry(frame).pts_ns);
+    };
+
+    const TerminalSize term = getTerminalSize();
+    const bool synchronized = querySynchronizedUpdates(constants::ASCII_VIDEO_SYNC_QUERY_TIMEOUT_MS);
+    writeStdout(PLAYBACK_SCREEN_SETUP);
+
+    std::clock_t cpu_start = std::clock();
+    auto start = Clock::now();
+    std::string batch; // Frames that go out in one write (the seek, or frames due together)
+    size_t writes = 0;
+    size_t bytes = 0;
+    size_t batched = 0; // Frames sent in a write with others
+    size_t skipped = 0; // Frames passed over by seeking to a newer one
+    std::string output_error;
+    for (size_t frame = first; frame < count;)
+    {
+        // Wait for the frame, then find the newest frame that is due by now
+        size_t newest = frame;
+        if (!unpaced)
+        {
+            std::this_thread::sleep_until(start + (pts(frame) - pts(first)));
+            const auto now = Clock::now();
+            while (newest + 1 < count && start + (pts(newest + 1) - pts(first)) <= now)
+            {
+                newest++;
+            }
+        }
+
+        // Seek when that is shorter than the deltas up to the newest frame (and always for the first frame,
+        // since the terminal's state is unknown); the deltas are only summed as far as the seek would cost
+        size_t seek_bytes = 0;
+        for (size_t i = video->entry(newest).keyframe; i <= newest; i++)
+        {
+            seek_bytes += video->entry(i).size;
+        }
+        size_t delta_bytes = 0;
+        for (size_t i = frame; i <= newest && delta_bytes <= seek_bytes; i++)
+        {
+            delta_bytes += video->entry(i).size;
+        }
+
+        batch.clear();
+        if (synchronized)
+        {
+            batch += SYNC_UPDATE_BEGIN;
+        }
+        size_t taken = 0;
+        if (frame == first || seek_bytes < delta_bytes)
+        {
+            video->appendSeek(newest, batch);
+            skipped += newest - frame;
+            frame = newest + 1;
+            taken = 1;
+        }
+        else
+        {
+            // Deltas in order, split over several writes if they add up to more than the batch limit
+            while (frame <= newest && (taken == 0 || batch.size() + video->entry(frame).size <= constants::ASCII_VIDEO_MAX_BATCH_BYTES))
+            {
+                batch.append(video->frameData(frame), video->entry(frame).size);
+                frame++;
+                taken++;
+            }
+        }
+        batched += taken > 1 ? taken : 0;
+        if (synchronized)
+        {
+            batch += SYNC_UPDATE_END;
+        }
+        try
+        {
+            writes += writeStdout(batch);
+        }
+        catch (const std::exception &e)
+        {
+            output_error = e.what();
+            break;
+        }
+        bytes += batch.size();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double cpu_seconds = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    writeStdout(PLAYBACK_SCREEN_RESTORE);
+    if (!output_error.empty())
+    {
+        std::cerr << "Error: " << output_error << std::endl;
+        return false;
+    }
+
+    if (static_cast<int>(video->header().width) > term.width || static_cast<int>(video->header().height) > term.height)
+    {
+        std::cerr << "Note: the video was recorded for " << video->header().width << "x" << video->header().height
+                  << " cells; this terminal is " << term.width << "x" << term.height << std::endl;
+    }
+    if (options.show_stats)
+    {
+        std::cerr << std::fixed << std::setprecision(2) << "Frames: " << count - first << " in " << seconds
+                  << "s from a recording (" << batched << " sent together with others after a stall, " << skipped
+                  << " skipped by seeking ahead)\n"
+                  << "Output: " << bytes << " bytes in " << writes << " write calls\n"
+                  << "CPU time: " << cpu_seconds * 1000.0 << " ms (" << (seconds > 0 ? 100.0 * cpu_seconds / seconds : 0.0)
+                  << "% of one core)" << std::endl;
+    }
+    return true;
+}
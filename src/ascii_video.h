@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ascii_art.h"
+#include "video.h"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Recorded ASCII video (.pxv): rendered frames stored as the exact bytes sent to a terminal, so playback
+// only has to copy them out. Layout:
+//   AsciiVideoHeader
+//   frame data: keyframes (clear screen, home, sparse full frame) and delta frames (appendGridDelta bytes)
+//   frame index: one AsciiVideoIndexEntry per frame
+// Every frame records the keyframe it builds on, so any frame can be shown by sending its keyframe and the
+// deltas after it. Integers are stored in the writing machine's byte order, like the pixel cache.
+
+// File header
+struct AsciiVideoHeader
+{
+    char magic[8];         // constants::ASCII_VIDEO_MAGIC (includes the format version)
+    uint32_t flags;        // ASCII_VIDEO_FLAG_* bits
+    uint32_t width;        // Grid size of the first frame in cells
+    uint32_t height;
+    uint32_t keyframe_interval; // Frames from one regular keyframe to the next
+    uint64_t frame_count;
+    uint64_t index_offset; // File offset of the frame index (0 while the file is being written)
+    int64_t duration_ns;   // End of the last frame
+};
+
+// Set in AsciiVideoHeader::flags when the frames use color escapes
+const uint32_t ASCII_VIDEO_FLAG_COLOR = 1;
+
+// One frame of the index
+struct AsciiVideoIndexEntry
+{
+    uint64_t offset;   // File offset of the frame's bytes
+    uint32_t size;     // Byte count (0 for a frame that changed nothing)
+    uint32_t keyframe; // Index of the keyframe this frame builds on (itself for a keyframe)
+    int64_t pts_ns;    // Presentation time relative to the first frame
+};
+
+// Writes a recorded ASCII video frame by frame, as a video export sink.
+// Memory use is the frame being encoded, the previous frame and the index (24 bytes per frame).
+class AsciiVideoWriter : public FrameSink
+{
+public:
+    // path: Output file (replaced if it exists)
+    // Throws: std::runtime_error if the file can't be created
+    explicit AsciiVideoWriter(const std::string &path);
+
+    // Encode a frame: a keyframe for the first frame, after a size change and every keyframe interval,
+    // otherwise the delta from the previous frame
+    void addFrame(const CellGrid &frame, std::chrono::nanoseconds pts) override;
+
+    // Write the index and complete the header
+    void finish(std::chrono::nanoseconds duration) override;
+
+private:
+    std::string path;
+    std::ofstream file;
+    AsciiVideoHeader header;
+    std::vector<AsciiVideoIndexEntry> index;
+    CellGrid previous;       // The frame before, to encode the next delta against
+    std::string bytes;       // Encoding buffer, reused
+    uint64_t offset = 0;     // Where the next frame's bytes go
+    uint32_t last_keyframe = 0;
+};
+
+// A recorded ASCII video mapped into memory (read into memory on Windows). Frames are read in place;
+// nothing is copied or decoded.
+class AsciiVideoReader
+{
+public:
+    // path: A file written by AsciiVideoWriter
+    // Throws: std::runtime_error if the file can't be mapped or isn't a complete, valid recording
+    explicit AsciiVideoReader(const std::string &path);
+
+    const AsciiVideoHeader &header() const { return *head; }
+    size_t frameCount() const { return static_cast<size_t>(head->frame_count); }
+    const AsciiVideoIndexEntry &entry(size_t frame) const { return entries[frame]; }
+
+    // The bytes of one frame, as stored
+    const char *frameData(size_t frame) const { return base + entries[frame].offset; }
+
+    // The first frame whose presentation time is at or after 'pts' (binary search of the index;
+    // frameCount() if there is none)
+    size_t frameAt(std::chrono::nanoseconds pts) const;
+
+    // Append everything needed to show 'frame' on a terminal in any state: its keyframe and the deltas after it
+    void appendSeek(size_t frame, std::string &out) const;
+
+private:
+    std::shared_ptr<const void> mapping; // Unmapped (or freed) when the reader goes away
+    const char *base = nullptr;
+    const AsciiVideoHeader *head = nullptr;
+    const AsciiVideoIndexEntry *entries = nullptr;
+};
+
+// --- Function Declarations ---
+
+// Check if a file is a recorded ASCII video (by its extension)
+bool isAsciiVideoFile(const std::string &filename);
+
+// Play a recorded ASCII video in the terminal: the stored bytes are sent at their presentation times,
+// so playback costs next to no CPU. When several frames are due together (after a stall) the terminal catches
+// up to the newest in one write, by its deltas or by a seek, whichever is shorter.
+// path: The recording
+// options: frame_delay replaces the recorded timing with a fixed period (0: no pacing, one frame per write);
+//          start_seconds seeks;
+//          show_stats reports frames, bytes, write calls and CPU time
+// Returns: true if playback completed, false otherwise (an error is printed)
+bool playAsciiVideo(const std::string &path, const VideoOptions &options);
@@ -0,0 +1,170 @@
+#include "asciicast.h"
+#include "screen.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+
+// --- Constants ---
+namespace constants
+{
+    // File extension of asciicast recordings
+    const char ASCIICAST_EXTENSION[] = ".cast";
+    // Escaped events are written to the file in chunks of about this size
+    const size_t ASCIICAST_FLUSH_BYTES = 1 << 16;
+    // The first frame, and any frame after a size change, starts from a cleared screen with the cursor home
+    const char ASCIICAST_CLEAR[] = "\033[2J\033[1;1H";
+}
+// --- End Constants ---
+
+// --- JSON Encoding ---
+
+// Append a string as the contents of a JSON string literal (without the quotes).
+// Newlines become CR LF, which is what a terminal with output post-processing receives and what players expect.
+// Bytes from 0x80 up are copied as they are (the glyphs are the user's character set, UTF-8 if anything).
+static void appendJsonEscaped(const std::string &text, std::string &out)
+{
+    static const char HEX[] = "0123456789abcdef";
+    for (char c : text)
+    {
+        const unsigned char u = static_cast<unsigned char>(c);
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\r\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (u < 0x20 || u == 0x7f)
+            {
+                out += "\\u00";
+                out += HEX[u >> 4];
+                out += HEX[u & 0xf];
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+}
+
+// Append one output event line
+static void appendEvent(std::chrono::nanoseconds time, const std::string &output, std::string &out)
+{
+    char seconds[32];
+    std::snprintf(seconds, sizeof(seconds), "%.6f", std::chrono::duration<double>(time).count());
+    out += '[';
+    out += seconds;
+    out += ", \"o\", \"";
+    appendJsonEscaped(output, out);
+    out += "\"]\n";
+}
+
+// --- Writer ---
+
+AsciicastWriter::AsciicastWriter(const std::string &path, const std::string &title)
+    : path(path), title(title), file(path, std::ios::binary | std::ios::trunc)
+{
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open output file for writing: " + path);
+    }
+    buffer.reserve(constants::ASCIICAST_FLUSH_BYTES * 2);
+}
+
+void AsciicastWriter::addFrame(const CellGrid &frame, std::chrono::nanoseconds pts)
+{
+    frame_bytes.clear();
+    if (!started)
+    {
+        // The header has to come first, and the grid size is only known now
+        buffer += "{\"version\": 2, \"width\": " + std::to_string(frame.width) +
+                  ", \"height\": " + std::to_string(frame.height) +
+                  ", \"timestamp\": " + std::to_string(static_cast<long long>(std::time(nullptr)));
+        if (!title.empty())
+        {
+            buffer += ", \"title\": \"";
+            appendJsonEscaped(title, buffer);
+            buffer += '"';
+        }
+        buffer += ", \"env\": {\"TERM\": \"xterm-256color\"}}\n";
+    }
+    if (!started || frame.width != previous.width || frame.height != previous.height)
+    {
+        frame_bytes += constants::ASCIICAST_CLEAR;
+        appendGridSparse(frame, frame_bytes);
+        started = true;
+    }
+    else
+    {
+        appendGridDelta(previous, frame, frame_bytes);
+    }
+    previous = frame; // Same size from frame to frame, so this reuses previous's allocation
+
+    // A frame that changed nothing needs no event
+    if (!frame_bytes.empty())
+    {
+        appendEvent(pts, frame_bytes, buffer);
+        last_event = pts;
+    }
+    flush(constants::ASCIICAST_FLUSH_BYTES);
+}
+
+void AsciicastWriter::finish(std::chrono::nanoseconds duration)
+{
+    if (!started)
+    {
+        throw std::runtime_error("No frames to record in " + path);
+    }
+    if (duration > last_event)
+    {
+        appendEvent(duration, std::string(), buffer);
+    }
+    flush(0);
+    file.close();
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write asciicast recording: " + path);
+    }
+}
+
+void AsciicastWriter::flush(size_t threshold)
+{
+    if (buffer.empty() || buffer.size() < threshold)
+    {
+        return;
+    }
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write asciicast recording: " + path);
+    }
+    buffer.clear();
+}
+
+// --- Helpers ---
+
+// Check the extension, case-insensitively
+bool isAsciicastFile(const std::string &filename)
+{
+    const size_t length = sizeof(constants::ASCIICAST_EXTENSION) - 1;
+    if (filename.size() < length)
+    {
+        return false;
+    }
+    std::string extension = filename.substr(filename.size() - length);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == constants::ASCIICAST_EXTENSION;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ascii_art.h"
+#include <chrono>
+#include <fstream>
+#include <string>
+
+// Writes an asciicast v2 recording (https://docs.asciinema.org/manual/asciicast/v2/) frame by frame:
+// a JSON header line, then one ["<seconds>", "o", "<output>"] event line per frame that changed something.
+// Frames are encoded as a terminal would receive them (a cleared screen and the full frame first, then only
+// the cells that changed) and JSON-escaped straight into a write buffer that is flushed as it fills, so
+// memory use stays the same however long the recording runs: the previous frame, one encoded frame and the buffer.
+class AsciicastWriter : public FrameSink
+{
+public:
+    // path: Output file (replaced if it exists)
+    // title: Recording title for the header (empty for none)
+    // Throws: std::runtime_error if the file can't be created
+    AsciicastWriter(const std::string &path, const std::string &title);
+
+    // Write the frame as one output event. The first frame also writes the header, sized to it.
+    void addFrame(const CellGrid &frame, std::chrono::nanoseconds pts) override;
+
+    // Write an empty event at the end of the last frame, so players keep it up for its full period, and flush
+    // Throws: std::runtime_error if the file can't be written or no frame was added
+    void finish(std::chrono::nanoseconds duration) override;
+
+private:
+    // Write the buffer to the file once it holds this much or more (all of it when 'threshold' is 0)
+    void flush(size_t threshold);
+
+    std::string path;
+    std::string title;
+    std::ofstream file;
+    CellGrid previous;       // The frame before, to encode the next delta against
+    bool started = false;    // The header and first frame are written
+    std::string frame_bytes; // Terminal bytes of the frame being written, reused
+    std::string buffer;      // Escaped event lines waiting to be written
+    std::chrono::nanoseconds last_event{0};
+};
+
+// --- Function Declarations ---
+
+// Check if an output path names an asciicast recording (by its .cast extension)
+bool isAsciicastFile(const std::string &filename);
@@ -0,0 +1,356 @@
+#include "batch.h"
+#include "ascii_art.h"
+#include "output.h"
+#include "image.h"
+#include "cache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <functional>
+#include <map>
+#ifndef _WIN32
+#include <glob.h>
+#endif
+
+// --- Constants ---
+namespace constants
+{
+    // Files read ahead per worker, so decoding never waits on disk while more input is available
+    const size_t BATCH_READ_AHEAD_PER_WORKER = 2;
+}
+// --- End Constants ---
+
+// State shared between the reader thread and the workers of one batch run
+// Byte buffers cycle between 'free_buffers' and 'ready', so their allocations are reused across files.
+struct BatchContext
+{
+    const std::vector<std::string> &inputs;
+    const std::string &output_dir;
+    const AsciiArtParams &params;
+    std::vector<std::string> output_names; // Output file name of each input
+    RenderCaches caches; // Caches shared by all workers
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> free_buffers;              // Recycled buffers waiting to be filled
+    std::deque<std::pair<size_t, std::vector<uint8_t>>> ready; // (input index, file contents) waiting for a worker
+    bool reader_done = false;                                   // Every input has been queued
+
+    std::atomic<size_t> converted{0};
+    std::atomic<size_t> failed{0};
+    std::mutex log_mutex; // Keeps error lines from different workers intact
+
+    BatchContext(const std::vector<std::string> &inputs, const std::string &output_dir, const AsciiArtParams &params)
+        : inputs(inputs), output_dir(output_dir), params(params) {}
+};
+
+// Check if a path has an extension stb_image can decode as a still image
+static bool isBatchImageFile(const std::filesystem::path &path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" ||
+           ext == ".tga" || ext == ".psd" || ext == ".hdr" || ext == ".pic" ||
+           ext == ".pnm" || ext == ".ppm" || ext == ".pgm";
+}
+
+#ifdef _WIN32
+// Match a file name against a pattern of literal characters, '*' (any run) and '?' (any one character)
+static bool matchesWildcard(const char *pattern, const char *name)
+{
+    if (*pattern == '\0')
+    {
+        return *name == '\0';
+    }
+    if (*pattern == '*')
+    {
+        return matchesWildcard(pattern + 1, name) || (*name != '\0' && matchesWildcard(pattern, name + 1));
+    }
+    return *name != '\0' && (*pattern == '?' || *pattern == *name) && matchesWildcard(pattern + 1, name + 1);
+}
+#endif
+
+// Expand a glob pattern into the matching paths, sorted
+// Throws: std::runtime_error if the pattern can't be expanded
+static void expandGlob(const std::string &source, std::vector<std::string> &inputs)
+{
+#ifdef _WIN32
+    // No glob() on Windows: wildcards are matched against the names in one directory
+    const std::filesystem::path pattern(source);
+    const std::string dir = pattern.parent_path().string();
+    if (dir.find_first_of("*?[") != std::string::npos || source.find('[') != std::string::npos)
+    {
+        throw std::runtime_error("Only '*' and '?' in the file name are supported in glob patterns on Windows: " + source);
+    }
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(dir.empty() ? "." : dir, ec))
+    {
+        if (entry.is_regular_file() &&
+            matchesWildcard(pattern.filename().string().c_str(), entry.path().filename().string().c_str()))
+        {
+            inputs.push_back((dir.empty() ? entry.path().filename() : entry.path()).string());
+        }
+    }
+    std::sort(inputs.begin(), inputs.end());
+#else
+    // POSIX glob() (results are sorted)
+    glob_t matches;
+    int result = glob(source.c_str(), 0, nullptr, &matches);
+    if (result == 0)
+    {
+        for (size_t i = 0; i < matches.gl_pathc; i++)
+        {
+            inputs.push_back(matches.gl_pathv[i]);
+        }
+    }
+    globfree(&matches);
+    if (result != 0 && result != GLOB_NOMATCH)
+    {
+        throw std::runtime_error("Failed to expand glob pattern: " + source);
+    }
+#endif
+}
+
+// Expand a directory, glob pattern or list file into input paths
+std::vector<std::string> collectBatchInputs(const std::string &source)
+{
+    std::vector<std::string> inputs;
+
+    if (std::filesystem::is_directory(source))
+    {
+        // Every image file directly inside the directory
+        for (const auto &entry : std::filesystem::directory_iterator(source))
+        {
+            if (entry.is_regular_file() && isBatchImageFile(entry.path()))
+            {
+                inputs.push_back(entry.path().string());
+            }
+        }
+        std::sort(inputs.begin(), inputs.end());
+    }
+    else if (source.find_first_of("*?[") != std::string::npos)
+    {
+        expandGlob(source, inputs);
+    }
+    else
+    {
+        // List file: one input path per line
+        std::ifstream list(source);
+        if (!list.is_open())
+        {
+            throw std::runtime_error("Failed to open batch source (directory, glob or list file): " + source);
+        }
+        std::string line;
+        while (std::getline(list, line))
+        {
+            // Tolerate CRLF list files and skip blank and comment lines
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            if (!line.empty() && line[0] != '#')
+            {
+                inputs.push_back(line);
+            }
+        }
+    }
+
+    return inputs;
+}
+
+// Reader thread: reads files in order into recycled buffers, staying at most the buffer pool ahead of the workers
+static void batchReadAhead(BatchContext &ctx)
+{
+    for (size_t i = 0; i < ctx.inputs.size(); i++)
+    {
+        std::vector<uint8_t> bytes;
+        {
+            std::unique_lock<std::mutex> lock(ctx.mutex);
+            ctx.changed.wait(lock, [&ctx]() { return !ctx.free_buffers.empty(); });
+            bytes = std::move(ctx.free_buffers.front());
+            ctx.free_buffers.pop_front();
+        }
+
+        // An empty buffer tells the worker the read failed
+        if (!readFileBytes(ctx.inputs[i], bytes))
+        {
+            bytes.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(ctx.mutex);
+            ctx.ready.emplace_back(i, std::move(bytes));
+        }
+        ctx.changed.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(ctx.mutex);
+        ctx.reader_done = true;
+    }
+    ctx.changed.notify_all();
+}
+
+// Worker thread: decodes, renders and saves read-ahead files until the reader is done
+static void batchWorker(BatchContext &ctx)
+{
+    std::string ascii_text; // Per-worker output buffer, reused for every image
+    std::string error;
+
+    while (true)
+    {
+        std::pair<size_t, std::vector<uint8_t>> item;
+        {
+            std::unique_lock<std::mutex> lock(ctx.mutex);
+            ctx.changed.wait(lock, [&ctx]() { return !ctx.ready.empty() || ctx.reader_done; });
+            if (ctx.ready.empty())
+            {
+                break; // Reader finished and nothing is left
+            }
+            item = std::move(ctx.ready.front());
+            ctx.ready.pop_front();
+        }
+
+        const std::string &input = ctx.inputs[item.first];
+        bool ok = false;
+        try
+        {
+            // An empty buffer (failed read-ahead) makes renderImageFile read the file itself and report the error
+            if (renderImageFile(input, item.second, ctx.params, ctx.caches, ascii_text, error))
+            {
+                std::filesystem::path output = std::filesystem::path(ctx.output_dir) / ctx.output_names[item.first];
+                saveOutputText(ascii_text, output.string());
+                ok = true;
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(ctx.log_mutex);
+                std::cerr << "Error: " << input << ": " << error << std::endl;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::lock_guard<std::mutex> lock(ctx.log_mutex);
+            std::cerr << "Error: " << input << ": " << e.what() << std::endl;
+        }
+
+        (ok ? ctx.converted : ctx.failed)++;
+
+        // Hand the buffer back to the reader
+        {
+            std::lock_guard<std::mutex> lock(ctx.mutex);
+            ctx.free_buffers.push_back(std::move(item.second));
+        }
+        ctx.changed.notify_all();
+    }
+}
+
+// Name the output files: <stem>.txt, or <name>.txt (extension kept) for inputs that share a stem, such as
+// a.png and a.jpg. Inputs with the same file name in different directories can't be told apart that way.
+// Returns: false if two inputs would still be written to the same file (an error is printed)
+static bool nameBatchOutputs(const std::vector<std::string> &inputs, std::vector<std::string> &names)
+{
+    std::map<std::string, size_t> stems;
+    for (const std::string &input : inputs)
+    {
+        stems[std::filesystem::path(input).stem().string()]++;
+    }
+    std::map<std::string, size_t> used; // Output name -> input index
+    names.clear();
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        const std::filesystem::path path(inputs[i]);
+        std::string name = (stems[path.stem().string()] > 1 ? path.filename() : path.stem()).string() + ".txt";
+        auto inserted = used.emplace(name, i);
+        if (!inserted.second)
+        {
+            std::cerr << "Error: " << inputs[inserted.first->second] << " and " << inputs[i]
+                      << " would both be written to " << name << "; rename one or convert them separately." << std::endl;
+            return false;
+        }
+        names.push_back(name);
+    }
+    return true;
+}
+
+// Convert images on a pool of worker threads with a reader thread reading files ahead
+bool processBatch(const std::vector<std::string> &inputs, const std::string &output_dir,
+                  const AsciiArtParams &params, unsigned int jobs)
+{
+    if (jobs == 0)
+    {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    jobs = static_cast<unsigned int>(std::min<size_t>(jobs, std::max<size_t>(inputs.size(), 1)));
+
+    BatchContext ctx(inputs, output_dir, params);
+    if (!nameBatchOutputs(inputs, ctx.output_names))
+    {
+        return false;
+    }
+    std::filesystem::create_directories(output_dir);
+    ctx.free_buffers.resize(jobs * constants::BATCH_READ_AHEAD_PER_WORKER);
+
+    // Caches are shared by all workers, so hit/miss statistics cover the whole run
+    std::unique_ptr<OutputCache> output_cache;
+    std::unique_ptr<PixelCache> pixel_cache;
+    if (!params.cache_dir.empty())
+    {
+        output_cache = std::make_unique<OutputCache>(params.cache_dir, params.cache_max_bytes);
+        ctx.caches.output = output_cache.get();
+    }
+    if (!params.pixel_cache_dir.empty())
+    {
+        pixel_cache = std::make_unique<PixelCache>(params.pixel_cache_dir, params.pixel_cache_max_bytes);
+        ctx.caches.pixels = pixel_cache.get();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread reader(batchReadAhead, std::ref(ctx));
+    std::vector<std::thread> workers;
+    for (unsigned int w = 0; w < jobs; w++)
+    {
+        workers.emplace_back(batchWorker, std::ref(ctx));
+    }
+
+    reader.join();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    // --- Throughput Report ---
+    size_t converted = ctx.converted.load();
+    size_t failed = ctx.failed.load();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Converted " << converted << " of " << inputs.size() << " images";
+    if (failed > 0)
+    {
+        std::cout << " (" << failed << " failed)";
+    }
+    std::cout << " in " << std::fixed << std::setprecision(2) << seconds << "s using " << jobs << " jobs ("
+              << std::setprecision(1) << (seconds > 0 ? static_cast<double>(converted) / seconds : 0.0)
+              << " images/s)" << std::endl;
+    if (output_cache)
+    {
+        printCacheStats(std::cout, "Output cache", output_cache->stats());
+    }
+    if (pixel_cache)
+    {
+        printCacheStats(std::cout, "Pixel cache", pixel_cache->stats());
+    }
+
+    return failed == 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "ascii_art.h"
+#include <string>
+#include <vector>
+
+// --- Function Declarations ---
+
+// Expand a batch source into the list of image files to convert.
+// source: A directory (its image files, non-recursive), a glob pattern (e.g. "shots/*.png"),
+//         or a list file with one path per line (blank lines and lines starting with '#' are skipped).
+// Returns: The input paths, sorted for directories and globs, in file order for list files.
+// Throws: std::runtime_error if the source cannot be read.
+std::vector<std::string> collectBatchInputs(const std::string &source);
+
+// Convert many images in parallel, writing one <name>.txt per input into output_dir.
+// Inputs that share a name without its extension (a.png, a.jpg) keep the extension: a.png.txt, a.jpg.txt.
+// Nothing is converted if two inputs would still get the same output file (same name in different directories).
+// inputs: Paths of the images to convert.
+// output_dir: Directory for the generated text files (created if missing).
+// params: ASCII art parameters applied to every image (input_path and output_path are ignored).
+//         Output and pixel caches configured in params are shared by all workers and their statistics are reported.
+// jobs: Number of worker threads (0 picks the hardware concurrency).
+// Prints a throughput summary (images per second) when done.
+// Returns: true if every image was converted, false if any failed or the output names collide.
+bool processBatch(const std::vector<std::string> &inputs, const std::string &output_dir,
+                  const AsciiArtParams &params, unsigned int jobs);
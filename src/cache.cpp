@@ -0,0 +1,510 @@
+#include "cache.h"
+#include "image.h"
+#include "output.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// --- Constants ---
+namespace constants
+{
+    // Bumped whenever the rendered output for the same settings changes, so stale entries stop matching
+    const char OUTPUT_CACHE_FORMAT_TAG[] = "pixcii-output-cache-1";
+    // Extensions of the entry files, so both caches can share one directory
+    const char OUTPUT_CACHE_EXTENSION[] = ".txt";
+    const char PIXEL_CACHE_EXTENSION[] = ".pix";
+    // Magic at the start of pixel cache entries (includes the format version)
+    const char PIXEL_CACHE_MAGIC[8] = {'P', 'X', 'C', 'P', 'I', 'X', '0', '1'};
+    // Entry files are named <key><extension>, the key being this many lowercase hex digits (CacheKey::toHex)
+    const size_t CACHE_KEY_HEX_DIGITS = 32;
+    // Entries are written to "<entry>.tmp<pid>-<n>" first, then renamed into place
+    const char CACHE_TEMP_SUFFIX[] = ".tmp";
+    // Temporary files older than this were left by a run that crashed or was killed, and are removed
+    const auto CACHE_STALE_TEMP_AGE = std::chrono::minutes(10);
+}
+// --- End Constants ---
+
+// Format the key as 32 lowercase hex digits
+std::string CacheKey::toHex() const
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(32, '0');
+    for (int i = 0; i < 16; i++)
+    {
+        hex[15 - i] = digits[(high >> (i * 4)) & 0xf];
+        hex[31 - i] = digits[(low >> (i * 4)) & 0xf];
+    }
+    return hex;
+}
+
+static uint64_t rotateLeft(uint64_t x, int bits)
+{
+    return (x << bits) | (x >> (64 - bits));
+}
+
+// Final avalanche so every input bit affects every output bit
+static uint64_t finalizeHash(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Hash a byte range, 8 bytes per step, into two independent lanes
+CacheKey hashBytes(const void *data, size_t size, const CacheKey &seed)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint64_t h1 = seed.high ^ (size * 0x9e3779b97f4a7c15ULL);
+    uint64_t h2 = seed.low ^ 0x6a09e667f3bcc909ULL;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        h1 = rotateLeft(h1 ^ (word * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+        h2 = rotateLeft(h2 ^ (word * 0x4cf5ad432745937fULL), 27) * 0x87c37b91114253d5ULL;
+    }
+
+    // Remaining 0-7 bytes
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes + i, size - i);
+    h1 = rotateLeft(h1 ^ (tail * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+    h2 = rotateLeft(h2 ^ (tail * 0x4cf5ad432745937fULL), 27) * 0x87c37b91114253d5ULL;
+
+    CacheKey key;
+    key.high = finalizeHash(h1 + h2);
+    key.low = finalizeHash(h2 ^ rotateLeft(h1, 17));
+    return key;
+}
+
+// Append a value's bytes to a key blob
+template <typename T>
+static void appendKeyField(std::string &blob, const T &value)
+{
+    blob.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Check for a run of lowercase hex digits (the characters CacheKey::toHex writes)
+static bool isLowerHex(const std::string &text, size_t begin, size_t count)
+{
+    if (text.size() < begin + count)
+    {
+        return false;
+    }
+    for (size_t i = begin; i < begin + count; i++)
+    {
+        const char c = text[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check for a run of at least one decimal digit from 'begin' to 'end'
+static bool isDecimal(const std::string &text, size_t begin, size_t end)
+{
+    if (begin >= end)
+    {
+        return false;
+    }
+    for (size_t i = begin; i < end; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check that a file name is exactly <key><extension>, so other files sharing the directory are never adopted
+static bool isEntryName(const std::string &name, const std::string &extension)
+{
+    const size_t digits = constants::CACHE_KEY_HEX_DIGITS;
+    return name.size() == digits + extension.size() && isLowerHex(name, 0, digits) &&
+           name.compare(digits, extension.size(), extension) == 0;
+}
+
+// Check that a file name is exactly <key><extension>.tmp<pid>-<n>, the temporary name CacheDirectory::write uses
+static bool isTempEntryName(const std::string &name, const std::string &extension)
+{
+    const std::string prefix_tail = extension + constants::CACHE_TEMP_SUFFIX;
+    const size_t digits = constants::CACHE_KEY_HEX_DIGITS;
+    if (!isLowerHex(name, 0, digits) || name.compare(digits, prefix_tail.size(), prefix_tail) != 0)
+    {
+        return false;
+    }
+    const size_t numbers = digits + prefix_tail.size();
+    const size_t dash = name.find('-', numbers);
+    return dash != std::string::npos && isDecimal(name, numbers, dash) && isDecimal(name, dash + 1, name.size());
+}
+
+// Scan the cache directory and order existing entries by last use (modification time)
+CacheDirectory::CacheDirectory(const std::string &dir, const std::string &extension, uint64_t max_bytes)
+    : dir(dir), extension(extension), max_bytes(max_bytes)
+{
+    std::filesystem::create_directories(dir);
+
+    struct ScannedEntry
+    {
+        std::filesystem::file_time_type last_used;
+        Entry entry;
+    };
+    std::vector<ScannedEntry> scanned;
+
+    const auto stale_before = std::filesystem::file_time_type::clock::now() - constants::CACHE_STALE_TEMP_AGE;
+    for (const auto &file : std::filesystem::directory_iterator(dir))
+    {
+        if (!file.is_regular_file())
+        {
+            continue;
+        }
+        // Only files named like entries count: anything else (e.g. a user's own text files) is never evicted
+        const std::string name = file.path().filename().string();
+        if (isEntryName(name, extension))
+        {
+            scanned.push_back({file.last_write_time(), {name, file.file_size()}});
+        }
+        else if (isTempEntryName(name, extension) && file.last_write_time() < stale_before)
+        {
+            // An entry that was never renamed into place; newer ones may still be written by another process
+            std::error_code ec;
+            std::filesystem::remove(file.path(), ec);
+        }
+    }
+
+    std::sort(scanned.begin(), scanned.end(),
+              [](const ScannedEntry &a, const ScannedEntry &b) { return a.last_used > b.last_used; });
+
+    for (const auto &item : scanned)
+    {
+        lru.push_back(item.entry);
+        index[item.entry.name] = std::prev(lru.end());
+        total_bytes += item.entry.size;
+    }
+
+    // The limit may have been lowered since the last run
+    std::lock_guard<std::mutex> lock(mutex);
+    evictLocked();
+}
+
+std::filesystem::path CacheDirectory::entryPath(const CacheKey &key) const
+{
+    return std::filesystem::path(dir) / (key.toHex() + extension);
+}
+
+// Mark an entry most recently used, both in memory and in its modification time
+bool CacheDirectory::acquire(const CacheKey &key)
+{
+    const std::string name = key.toHex() + extension;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(name);
+        if (it == index.end())
+        {
+            miss_count++;
+            return false;
+        }
+        lru.splice(lru.begin(), lru, it->second);
+        hit_count++;
+    }
+
+    // Persist recency for the next run's eviction order
+    std::error_code ec;
+    std::filesystem::last_write_time(entryPath(key), std::filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+// Forget an entry that vanished or failed validation
+void CacheDirectory::reject(const CacheKey &key)
+{
+    const std::string name = key.toHex() + extension;
+    std::error_code ec;
+    std::filesystem::remove(entryPath(key), ec);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(name);
+    if (it != index.end())
+    {
+        total_bytes -= it->second->size;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    hit_count--;
+    miss_count++;
+}
+
+// Write an entry atomically (temporary file + rename), then enforce the size limit.
+// The temporary name holds the process id and a per-process counter, so processes sharing the directory
+// never write into the same temporary file.
+void CacheDirectory::write(const CacheKey &key, const void *header, size_t header_size, const void *payload, size_t payload_size)
+{
+    static std::atomic<uint64_t> temp_counter{0};
+#ifdef _WIN32
+    static const long long process_id = _getpid();
+#else
+    static const long long process_id = getpid();
+#endif
+
+    const std::string name = key.toHex() + extension;
+    const std::filesystem::path path = entryPath(key);
+    const std::filesystem::path temp_path = path.string() + constants::CACHE_TEMP_SUFFIX + std::to_string(process_id) +
+                                            "-" + std::to_string(temp_counter++);
+
+    {
+        std::ofstream file(temp_path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return; // The cache is an optimization; failing to fill it is not an error
+        }
+        file.write(static_cast<const char *>(header), static_cast<std::streamsize>(header_size));
+        file.write(static_cast<const char *>(payload), static_cast<std::streamsize>(payload_size));
+        if (!file)
+        {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(temp_path, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(name);
+    if (it != index.end())
+    {
+        // Another worker stored the same entry concurrently
+        total_bytes -= it->second->size;
+        lru.erase(it->second);
+    }
+    lru.push_front({name, header_size + payload_size});
+    index[name] = lru.begin();
+    total_bytes += header_size + payload_size;
+    evictLocked();
+}
+
+// Drop least-recently-used entries from the back of the list
+void CacheDirectory::evictLocked()
+{
+    while (total_bytes > max_bytes && !lru.empty())
+    {
+        const Entry &victim = lru.back();
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::path(dir) / victim.name, ec);
+        total_bytes -= victim.size;
+        index.erase(victim.name);
+        lru.pop_back();
+        eviction_count++;
+    }
+}
+
+uint64_t CacheDirectory::hits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hit_count;
+}
+
+uint64_t CacheDirectory::misses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return miss_count;
+}
+
+uint64_t CacheDirectory::evictions() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return eviction_count;
+}
+
+void printCacheStats(std::ostream &out, const char *name, const CacheDirectory &stats)
+{
+    out << name << ": " << stats.hits() << " hits, " << stats.misses() << " misses, " << stats.evictions()
+        << " evicted" << std::endl;
+}
+
+// --- Output Cache ---
+
+OutputCache::OutputCache(const std::string &dir, uint64_t max_bytes)
+    : entries(dir, constants::OUTPUT_CACHE_EXTENSION, max_bytes)
+{
+}
+
+// Key = hash(input bytes) chained with a hash of every setting that changes the rendered text
+CacheKey OutputCache::makeKey(const uint8_t *bytes, size_t size, const AsciiArtParams &params)
+{
+    std::string blob = constants::OUTPUT_CACHE_FORMAT_TAG;
+    blob += params.ascii_chars;
+    blob += '\0';
+    appendKeyField(blob, params.color);
+    appendKeyField(blob, params.invert_color);
+    appendKeyField(blob, params.brightness_boost);
+    appendKeyField(blob, params.detect_edges);
+    appendKeyField(blob, params.aspect_ratio);
+    appendKeyField(blob, params.auto_fit);
+    appendKeyField(blob, params.composite_alpha);
+    appendKeyField(blob, params.background);
+
+    // Output geometry: auto-fit follows the terminal, original-size mode follows the scale factor
+    if (params.auto_fit)
+    {
+        TerminalSize term = getTerminalSize();
+        appendKeyField(blob, term.width);
+        appendKeyField(blob, term.height);
+    }
+    else
+    {
+        appendKeyField(blob, params.scale);
+    }
+
+    return hashBytes(blob.data(), blob.size(), hashBytes(bytes, size));
+}
+
+// Read a stored output
+bool OutputCache::lookup(const CacheKey &key, std::string &ascii_text)
+{
+    if (!entries.acquire(key))
+    {
+        return false;
+    }
+
+    // Read outside any lock so workers don't serialize on file I/O
+    std::ifstream file(entries.entryPath(key), std::ios::binary);
+    std::ostringstream contents;
+    if (file.is_open())
+    {
+        contents << file.rdbuf();
+    }
+    if (!file.is_open() || !file || !contents)
+    {
+        // Entry vanished (e.g. another process evicted it): treat as a miss
+        entries.reject(key);
+        return false;
+    }
+    ascii_text = contents.str();
+    return true;
+}
+
+void OutputCache::store(const CacheKey &key, const std::string &ascii_text)
+{
+    entries.write(key, nullptr, 0, ascii_text.data(), ascii_text.size());
+}
+
+// --- Pixel Cache ---
+
+// Header at the start of every pixel cache entry, followed by width * height * channels bytes
+struct PixelCacheHeader
+{
+    char magic[8];     // constants::PIXEL_CACHE_MAGIC
+    uint32_t width;    // Image width in pixels
+    uint32_t height;   // Image height in pixels
+    uint32_t channels; // Channels per pixel
+    uint32_t order;    // ChannelOrder of the pixels (0 = RGB); also keeps the pixel data 8-byte aligned
+};
+
+PixelCache::PixelCache(const std::string &dir, uint64_t max_bytes)
+    : entries(dir, constants::PIXEL_CACHE_EXTENSION, max_bytes)
+{
+}
+
+// Key = hash of (absolute path, modification time, size, decoded channel count)
+bool PixelCache::makeKey(const std::string &path, int channels, CacheKey &key)
+{
+    // std::filesystem rather than stat(), so this builds on Windows too (same resolution on Linux: nanoseconds)
+    std::error_code ec;
+    const auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec)
+    {
+        return false;
+    }
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec)
+    {
+        return false;
+    }
+
+    std::string blob = std::filesystem::absolute(path, ec).string();
+    blob += '\0';
+    appendKeyField(blob, static_cast<int64_t>(modified.time_since_epoch().count()));
+    appendKeyField(blob, static_cast<int64_t>(size));
+    appendKeyField(blob, channels);
+
+    key = hashBytes(blob.data(), blob.size());
+    return true;
+}
+
+// Map an entry, validate its header and view the pixels in place
+bool PixelCache::lookup(const CacheKey &key, ImageView &img)
+{
+    if (!entries.acquire(key))
+    {
+        return false;
+    }
+
+    ReadOnlyFile file;
+    if (!readOnlyFile(entries.entryPath(key).string(), file) || file.size < sizeof(PixelCacheHeader))
+    {
+        entries.reject(key);
+        return false;
+    }
+
+    // Header check: magic and a size that matches the stored dimensions
+    const PixelCacheHeader *header = static_cast<const PixelCacheHeader *>(file.data.get());
+    const size_t pixel_bytes = static_cast<size_t>(header->width) * header->height * header->channels;
+    if (std::memcmp(header->magic, constants::PIXEL_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        file.size != sizeof(PixelCacheHeader) + pixel_bytes)
+    {
+        entries.reject(key);
+        return false;
+    }
+
+    // The view reads the pixels straight from the mapping and unmaps it when the last copy is gone
+    const uint8_t *pixels = reinterpret_cast<const uint8_t *>(file.bytes()) + sizeof(PixelCacheHeader);
+    img = ImageView(pixels, static_cast<int>(header->width), static_cast<int>(header->height),
+                    static_cast<int>(header->channels), 0,
+                    header->order == static_cast<uint32_t>(ChannelOrder::BGR) ? ChannelOrder::BGR : ChannelOrder::RGB);
+    img.keep_alive = file.data;
+    return true;
+}
+
+void PixelCache::store(const CacheKey &key, const ImageView &img)
+{
+    // Entries hold packed rows; views with padded rows (crops, video frames) are packed first
+    if (!img.isPacked())
+    {
+        store(key, copyImage(img));
+        return;
+    }
+
+    PixelCacheHeader header;
+    std::memcpy(header.magic, constants::PIXEL_CACHE_MAGIC, sizeof(header.magic));
+    header.width = static_cast<uint32_t>(img.width);
+    header.height = static_cast<uint32_t>(img.height);
+    header.channels = static_cast<uint32_t>(img.channels);
+    header.order = static_cast<uint32_t>(img.order);
+    entries.write(key, &header, sizeof(header), img.data,
+                  static_cast<size_t>(img.width) * static_cast<size_t>(img.height) * static_cast<size_t>(img.channels));
+}
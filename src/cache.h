@@ -0,0 +1,137 @@
+#pragma once
+
+#include "ascii_art.h"
+#include "image.h"
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <ostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 128-bit content key identifying one cache entry
+struct CacheKey
+{
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    // Hex representation, used as the cache file name
+    std::string toHex() const;
+};
+
+// Hash a byte range into a 128-bit key.
+// Processes 8 bytes per step with two independent multiply-rotate lanes; not cryptographic.
+// data, size: The bytes to hash.
+// seed: Key to chain from (e.g. the hash of earlier data), or an empty key.
+CacheKey hashBytes(const void *data, size_t size, const CacheKey &seed = CacheKey());
+
+// Size-bounded least-recently-used index over the entry files of one cache directory.
+// Each entry is one file named <key><extension>. Recency is kept in the files' modification times,
+// so the eviction order survives between runs. All methods are safe to call from several threads.
+class CacheDirectory
+{
+public:
+    // dir: Cache directory (created if missing).
+    // extension: File extension of this cache's entries (e.g. ".txt"). Only files named <32 hex digits><extension>
+    //            are adopted as entries; other files are left alone, except temporary entry files
+    //            (<entry>.tmp<pid>-<n>) that a crashed run left behind, which are removed.
+    // max_bytes: Size limit for all entries together.
+    CacheDirectory(const std::string &dir, const std::string &extension, uint64_t max_bytes);
+
+    // Path of the entry file for a key (whether or not it exists).
+    std::filesystem::path entryPath(const CacheKey &key) const;
+
+    // Check for an entry and mark it most recently used; counts a hit or a miss.
+    // Returns: true if the entry exists and can be read from entryPath(key).
+    bool acquire(const CacheKey &key);
+
+    // Drop an entry that turned out to be unreadable or invalid after acquire(); its hit becomes a miss.
+    void reject(const CacheKey &key);
+
+    // Write an entry atomically (temporary file + rename) from a header and a payload, then enforce the size limit.
+    // Failures are ignored: the cache is an optimization.
+    void write(const CacheKey &key, const void *header, size_t header_size, const void *payload, size_t payload_size);
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+    uint64_t evictions() const;
+
+private:
+    struct Entry
+    {
+        std::string name; // File name inside the cache directory
+        uint64_t size;    // File size in bytes
+    };
+
+    // Remove least-recently-used entries until the total fits the limit. Caller holds 'mutex'.
+    void evictLocked();
+
+    std::string dir;
+    std::string extension;
+    uint64_t max_bytes;
+    uint64_t total_bytes = 0;
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+    uint64_t eviction_count = 0;
+
+    std::list<Entry> lru; // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    mutable std::mutex mutex;
+};
+
+// Print one line of cache statistics: "<name>: <hits> hits, <misses> misses, <evictions> evicted"
+void printCacheStats(std::ostream &out, const char *name, const CacheDirectory &stats);
+
+// On-disk cache of rendered ASCII output, addressed by the content of the input and the render settings.
+class OutputCache
+{
+public:
+    // dir: Cache directory (created if missing). max_bytes: Size limit for all entries together.
+    OutputCache(const std::string &dir, uint64_t max_bytes);
+
+    // Build the key for one input: the encoded file bytes, every parameter that affects the output,
+    // and the output geometry (the terminal size when auto-fitting).
+    static CacheKey makeKey(const uint8_t *bytes, size_t size, const AsciiArtParams &params);
+
+    // Look up a rendered output.
+    // Returns: true on a hit (ascii_text receives the stored output), false on a miss.
+    bool lookup(const CacheKey &key, std::string &ascii_text);
+
+    // Store a rendered output, evicting old entries if the cache grows past its limit.
+    void store(const CacheKey &key, const std::string &ascii_text);
+
+    // Hit/miss/eviction statistics
+    const CacheDirectory &stats() const { return entries; }
+
+private:
+    CacheDirectory entries;
+};
+
+// On-disk cache of decoded pixels, so re-rendering a source at another size or with another charset
+// skips decoding. Entries are keyed by the source's path, modification time and size plus the decoded
+// channel count, and hold a small header (width, height, channels) followed by the raw pixels.
+// Hits are memory-mapped.
+class PixelCache
+{
+public:
+    // dir: Cache directory (created if missing). max_bytes: Size limit for all entries together.
+    PixelCache(const std::string &dir, uint64_t max_bytes);
+
+    // Build the key for a source file decoded into 'channels' channels.
+    // Returns: false if the file can't be stat'ed (nothing can be cached for it).
+    static bool makeKey(const std::string &path, int channels, CacheKey &key);
+
+    // Look up decoded pixels.
+    // Returns: true on a hit (img becomes a view of the mapped entry, which it keeps mapped), false on a miss.
+    bool lookup(const CacheKey &key, ImageView &img);
+
+    // Store decoded pixels, evicting old entries if the cache grows past its limit.
+    void store(const CacheKey &key, const ImageView &img);
+
+    // Hit/miss/eviction statistics
+    const CacheDirectory &stats() const { return entries; }
+
+private:
+    CacheDirectory entries;
+};
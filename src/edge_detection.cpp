@@ -19,12 +19,13 @@ const int sobel_y[3][3] = {
 // --- End Constants ---
 
 // Perform Sobel edge detection on an image
-// img: The input Image struct
+// img: The input pixels; only the packed grayscale copy is read after the first pass
+// background: Optional RGB color for compositing transparent pixels (nullptr to ignore alpha)
 // Returns: A vector of floats representing the magnitude of the gradient at each pixel
-std::vector<float> detectEdges(const Image &img)
+std::vector<float> detectEdges(const ImageView &img, const uint8_t *background)
 {
     // Convert the image to grayscale, as Sobel operates on single-channel images
-    std::vector<uint8_t> gray = rgbToGrayscale(img);
+    std::vector<uint8_t> gray = rgbToGrayscale(img, background);
 
     // Vector to store the calculated edge magnitude for each pixel
     // Initialized with size img.width * img.height and values 0.0f
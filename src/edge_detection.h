@@ -5,6 +5,7 @@
 // --- Function Declarations ---
 
 // Performs edge detection on an image using the Sobel operator.
-// img: The input Image struct.
+// img: The input pixels (any stride).
+// background: Optional RGB color that transparent pixels are composited over before edges are measured.
 // Returns: A vector of floats where each element is the edge magnitude for the corresponding pixel.
-std::vector<float> detectEdges(const Image &img);
\ No newline at end of file
+std::vector<float> detectEdges(const ImageView &img, const uint8_t *background = nullptr);
\ No newline at end of file
@@ -13,6 +13,12 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <atomic>
+#include <climits>
+#include <mutex>
 
 // For terminal size detection - platform specific includes
 #ifdef _WIN32
@@ -20,6 +26,7 @@
 #else
 #include <sys/ioctl.h>
 #include <unistd.h>
+#include <signal.h>
 #endif
 
 // --- Constants ---
@@ -33,50 +40,253 @@ namespace constants
 }
 // --- End Constants ---
 
+// Map a channel count to the matching stb_image_resize2 pixel layout.
+// The enum values are not all equal to their channel counts, so map them explicitly.
+static stbir_pixel_layout pixelLayoutForChannels(int channels)
+{
+    switch (channels)
+    {
+    case 1:
+        return STBIR_1CHANNEL;
+    case 2:
+        return STBIR_RA; // Luma + alpha
+    case 3:
+        return STBIR_RGB;
+    case 4:
+        return STBIR_RGBA; // Alpha-weighted filtering so transparent pixels don't bleed color
+    default:
+        throw std::runtime_error("Unsupported channel count for resizing: " + std::to_string(channels));
+    }
+}
+
+// Rescale 16-bit samples to 8 bits, rounding to nearest (65535 -> 255).
+// A single flat loop over all samples so the compiler can vectorize it.
+static void rescale16To8(const uint16_t *src, uint8_t *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = static_cast<uint8_t>((src[i] + 128u) / 257u);
+    }
+}
+
+// Tone-map linear HDR samples to 8 bits.
+// Color channels use Reinhard (v / (1 + v)) followed by a gamma-2 encode (sqrt), which keeps highlights
+// instead of clipping them and vectorizes well. Alpha (the last channel of 2- and 4-channel images) is linear.
+static void toneMapHdrTo8(const float *src, uint8_t *dst, size_t pixels, int channels)
+{
+    const bool has_alpha = (channels == 2 || channels == 4);
+    const size_t count = pixels * static_cast<size_t>(channels);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float v = std::max(src[i], 0.0f);
+        dst[i] = static_cast<uint8_t>(std::sqrt(v / (1.0f + v)) * 255.0f + 0.5f);
+    }
+
+    // Alpha is coverage, not light: rescale it linearly over the tone-mapped value
+    if (has_alpha)
+    {
+        for (size_t p = 0; p < pixels; p++)
+        {
+            size_t i = p * static_cast<size_t>(channels) + static_cast<size_t>(channels - 1);
+            dst[i] = static_cast<uint8_t>(std::min(std::max(src[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+    }
+}
+
+// Read a whole file into a byte buffer, reusing the buffer's capacity
+bool readFileBytes(const std::string &path, std::vector<uint8_t> &bytes)
+{
+    bytes.clear();
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    // tellg reports -1 when the size can't be found (e.g. a pipe or a failed seek)
+    const std::streamoff size = file.tellg();
+    if (size < 0)
+    {
+        return false;
+    }
+    bytes.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+// Clamp a sub-rectangle to the view and return a view of it (no pixels are copied)
+ImageView ImageView::crop(int x, int y, int crop_width, int crop_height) const
+{
+    x = std::min(std::max(x, 0), width);
+    y = std::min(std::max(y, 0), height);
+    crop_width = std::min(std::max(crop_width, 0), width - x);
+    crop_height = std::min(std::max(crop_height, 0), height - y);
+
+    ImageView sub(pixel(x, y), crop_width, crop_height, channels, stride, order);
+    sub.keep_alive = keep_alive;
+    return sub;
+}
+
+// Pixel bytes copied by copyImage and Image copies
+static std::atomic<uint64_t> bytes_copied{0};
+
+Image::Image(const Image &other)
+    : data(other.data), width(other.width), height(other.height), channels(other.channels), order(other.order)
+{
+    bytes_copied += data.size();
+}
+
+Image &Image::operator=(const Image &other)
+{
+    data = other.data;
+    width = other.width;
+    height = other.height;
+    channels = other.channels;
+    order = other.order;
+    bytes_copied += data.size();
+    return *this;
+}
+
+uint64_t imageBytesCopied()
+{
+    return bytes_copied.load();
+}
+
+// Copy a view into a packed Image, one row at a time so padded strides are dropped
+Image copyImage(const ImageView &view)
+{
+    Image img;
+    img.width = view.width;
+    img.height = view.height;
+    img.channels = view.channels;
+    img.order = view.order;
+    const size_t row_bytes = static_cast<size_t>(view.width) * static_cast<size_t>(view.channels);
+    img.data.resize(row_bytes * static_cast<size_t>(view.height));
+    for (int y = 0; y < view.height; y++)
+    {
+        std::memcpy(img.data.data() + static_cast<size_t>(y) * row_bytes, view.row(y), row_bytes);
+    }
+    bytes_copied += img.data.size();
+    return img;
+}
+
+// Wrap a freshly converted Image in a view that owns it
+static ImageView viewOwning(std::shared_ptr<Image> owned)
+{
+    ImageView view(*owned);
+    view.keep_alive = std::move(owned);
+    return view;
+}
+
 // Load an image from a file path using the stb_image library.
-// Handles common image formats (like JPG, PNG, TGA, BMP, GIF, PSD, PIC).
-Image loadImage(const std::string &path)
+// Handles common image formats (like JPG, PNG, TGA, BMP, GIF, PSD, PIC, HDR).
+// desired_channels: 0 keeps the file's channel count; otherwise stb_image converts while decoding.
+ImageView loadImage(const std::string &path, int desired_channels)
+{
+    // Read the whole file once so the format probes and the decoder share a single read
+    std::vector<uint8_t> bytes;
+    if (!readFileBytes(path, bytes))
+    {
+        throw std::runtime_error("Failed to load image: " + path + " - can't read file");
+    }
+
+    try
+    {
+        return loadImageFromMemory(bytes.data(), bytes.size(), desired_channels);
+    }
+    catch (const std::runtime_error &e)
+    {
+        // Re-throw with the path so the user knows which file failed
+        throw std::runtime_error("Failed to load image: " + path + " - " + e.what());
+    }
+}
+
+// Decode an encoded image held in memory.
+// 8-bit files go through stbi_load and the decoder's buffer is handed out as is;
+// 16-bit files and Radiance HDR files are decoded at full precision and converted straight
+// into the 8-bit buffer in one pass, without an intermediate 8-bit copy.
+ImageView loadImageFromMemory(const uint8_t *bytes, size_t size, int desired_channels)
 {
-    Image img;                   // Create an Image struct to store the result
     int width, height, channels; // Variables to receive image dimensions and channel count
 
-    // Load the image data. Pass 0 for desired_channels to keep original channels.
+    // stb_image takes the length as an int
+    if (size > static_cast<size_t>(INT_MAX))
+    {
+        throw std::runtime_error("file too large to decode (" + std::to_string(size) + " bytes, the limit is 2 GiB)");
+    }
+    const int len = static_cast<int>(size);
+
+    if (stbi_is_hdr_from_memory(bytes, len))
+    {
+        // Linear float samples, converted to desired_channels by stb_image while decoding
+        float *data = stbi_loadf_from_memory(bytes, len, &width, &height, &channels, desired_channels);
+        if (!data)
+        {
+            throw std::runtime_error(stbi_failure_reason());
+        }
+        auto img = std::make_shared<Image>();
+        img->width = width;
+        img->height = height;
+        img->channels = desired_channels != 0 ? desired_channels : channels;
+        size_t pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+        img->data.resize(pixels * static_cast<size_t>(img->channels));
+        toneMapHdrTo8(data, img->data.data(), pixels, img->channels);
+        stbi_image_free(data);
+        return viewOwning(std::move(img));
+    }
+
+    if (stbi_is_16_bit_from_memory(bytes, len))
+    {
+        // 16-bit samples; stb_image computes luma at 16-bit precision when desired_channels is 1
+        uint16_t *data = stbi_load_16_from_memory(bytes, len, &width, &height, &channels, desired_channels);
+        if (!data)
+        {
+            throw std::runtime_error(stbi_failure_reason());
+        }
+        auto img = std::make_shared<Image>();
+        img->width = width;
+        img->height = height;
+        img->channels = desired_channels != 0 ? desired_channels : channels;
+        img->data.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(img->channels));
+        rescale16To8(data, img->data.data(), img->data.size());
+        stbi_image_free(data);
+        return viewOwning(std::move(img));
+    }
+
+    // Load the image data. stb_image converts to desired_channels while decoding
+    // (e.g. RGBA -> luma), so no extra conversion pass is needed afterwards.
     // stb_image loads data into a byte array (uint8_t*).
-    uint8_t *data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+    uint8_t *data = stbi_load_from_memory(bytes, len, &width, &height, &channels, desired_channels);
 
     // Check if image loading failed
     if (!data)
     {
         // Throw a runtime_error with a descriptive message if loading fails
-        throw std::runtime_error("Failed to load image: " + path + " - " + stbi_failure_reason());
+        throw std::runtime_error(stbi_failure_reason());
     }
 
-    // Populate our Image struct with the loaded data
-    img.width = width;
-    img.height = height;
-    img.channels = channels;
-
-    // Copy the loaded data into a std::vector owned by our Image struct.
-    // This allows automatic memory management (vector will delete data when img goes out of scope).
-    // Use static_cast<size_t> for multiplication result to avoid potential overflow before casting to size_t for size_t.
-    img.data.assign(data, data + static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(channels));
-
-    // Free the data allocated by stb_image_load, as our vector now holds the copy
-    stbi_image_free(data);
+    // 'channels' reports the file's own count; the buffer holds desired_channels when one was requested
+    if (desired_channels != 0)
+    {
+        channels = desired_channels;
+    }
 
-    // Return the populated Image struct
+    // Hand out stb_image's buffer without copying it.
+    // The view owns the buffer and frees it with stbi_image_free when the last copy of the view goes away.
+    ImageView img(data, width, height, channels);
+    img.keep_alive = std::shared_ptr<const void>(data, [](const void *p) { stbi_image_free(const_cast<void *>(p)); });
     return img;
 }
 
 // Resize an image using a scale factor and adjust height based on character aspect ratio.
 // This implementation now uses stb_image_resize2 for high-quality interpolation.
-// img: The input Image struct.
+// img: The input pixels.
 // scale: A scaling factor (e.g., 1.0 for no scaling, 2.0 to make output size ~half of input pixel dimensions).
 // aspect_ratio: The aspect ratio (width / height) of characters used for output. Vertical dimension is adjusted by this.
 // Returns: A new Image struct with the resized image data.
-Image resizeImage(const Image &img, float scale, float aspect_ratio)
+Image resizeImage(const ImageView &img, float scale, float aspect_ratio)
 {
-    Image resized; // Create a new Image struct for the resized data
 
     // Calculate new dimensions based on the scale factor and aspect ratio.
     // Note: scale > 1.0 typically means the resulting ASCII art has fewer characters (smaller output).
@@ -84,6 +294,16 @@ Image resizeImage(const Image &img, float scale, float aspect_ratio)
     int new_width = static_cast<int>(static_cast<float>(img.width) / scale);
     int new_height = static_cast<int>(static_cast<float>(img.height) / scale / aspect_ratio);
 
+    return resizeImageTo(img, new_width, new_height);
+}
+
+// Resize an image to exact pixel dimensions using stb_image_resize2.
+// Alpha layouts are filtered premultiplied, so fully transparent pixels contribute no color.
+// The source is read through its stride, so crops and padded frames need no packed copy.
+Image resizeImageTo(const ImageView &img, int new_width, int new_height)
+{
+    Image resized; // Create a new Image struct for the resized data
+
     // Ensure dimensions are at least 1x1 pixel
     new_width = std::max(new_width, 1);
     new_height = std::max(new_height, 1);
@@ -91,22 +311,21 @@ Image resizeImage(const Image &img, float scale, float aspect_ratio)
     resized.width = new_width;
     resized.height = new_height;
     resized.channels = img.channels;
+    resized.order = img.order; // Filtering is per channel, so the channel order carries over unchanged
     // Allocate memory for the resized image data vector. Use size_t for size calculation.
     resized.data.resize(static_cast<size_t>(new_width) * static_cast<size_t>(new_height) * static_cast<size_t>(img.channels));
 
     // --- Use stb_image_resize2 for Interpolation ---
 
     // Call the appropriate resize function from stb_image_resize2.h (stbir_resize_uint8_linear)
-    // We need to map img.channels (int) to stbir_pixel_layout enum.
-    // Common values for stbir_pixel_layout are STBIR_LUMINANCE (1), STBIR_RGB (3), STBIR_RGBA (4).
-    // We'll cast the int channel count to the enum type. This relies on the enum values matching channel counts.
-    stbir_pixel_layout layout = static_cast<stbir_pixel_layout>(img.channels);
+    // We need to map img.channels (int) to the stbir_pixel_layout enum.
+    stbir_pixel_layout layout = pixelLayoutForChannels(img.channels);
 
     unsigned char *result_ptr = stbir_resize_uint8_linear(
-        img.data.data(),              // input_pixels (const unsigned char*) - Pass const pointer to source data
+        img.data,                     // input_pixels (const unsigned char*) - Pass const pointer to source data
         img.width,                    // input_w (int)
         img.height,                   // input_h (int)
-        img.width * img.channels,     // input_stride_bytes (int)
+        static_cast<int>(img.stride), // input_stride_bytes (int)
         resized.data.data(),          // output_pixels (unsigned char*) - Pass non-const pointer to destination data
         new_width,                    // output_w (int)
         new_height,                   // output_h (int)
@@ -125,34 +344,133 @@ Image resizeImage(const Image &img, float scale, float aspect_ratio)
     return resized; // Return the resized image struct
 }
 
+// Prepared stb_image_resize2 resize and the geometry it was built for
+struct ResizePlan::State
+{
+    STBIR_RESIZE resize;
+    bool built = false; // Samplers are allocated and must be freed
+    int input_width = 0;
+    int input_height = 0;
+    int output_width = 0;
+    int output_height = 0;
+    int channels = 0;
+
+    ~State()
+    {
+        if (built)
+        {
+            stbir_free_samplers(&resize);
+        }
+    }
+};
+
+ResizePlan::ResizePlan() : state(std::make_unique<State>()) {}
+
+ResizePlan::~ResizePlan() = default;
+
+// Resize with the prepared samplers, rebuilding them first when the geometry changed.
+// Uses the same layout, data type, filters and edge mode as stbir_resize_uint8_linear, so results match resizeImageTo.
+void ResizePlan::resize(const ImageView &img, int new_width, int new_height, Image &out)
+{
+    // Ensure dimensions are at least 1x1 pixel
+    new_width = std::max(new_width, 1);
+    new_height = std::max(new_height, 1);
+
+    out.width = new_width;
+    out.height = new_height;
+    out.channels = img.channels;
+    out.order = img.order;
+    // Same size from frame to frame, so this allocates only when the geometry changes
+    out.data.resize(static_cast<size_t>(new_width) * static_cast<size_t>(new_height) * static_cast<size_t>(img.channels));
+
+    State &s = *state;
+    if (!s.built || s.input_width != img.width || s.input_height != img.height ||
+        s.output_width != new_width || s.output_height != new_height || s.channels != img.channels)
+    {
+        if (s.built)
+        {
+            stbir_free_samplers(&s.resize);
+            s.built = false;
+        }
+        stbir_resize_init(&s.resize, img.data, img.width, img.height, static_cast<int>(img.stride),
+                          out.data.data(), new_width, new_height, new_width * img.channels,
+                          pixelLayoutForChannels(img.channels), STBIR_TYPE_UINT8);
+        if (!stbir_build_samplers(&s.resize))
+        {
+            throw std::runtime_error("Image resizing failed using stb_image_resize2: could not build samplers.");
+        }
+        s.built = true;
+        s.input_width = img.width;
+        s.input_height = img.height;
+        s.output_width = new_width;
+        s.output_height = new_height;
+        s.channels = img.channels;
+        rebuild_count++;
+    }
+
+    // Buffers can move from call to call without invalidating the samplers
+    stbir_set_buffer_ptrs(&s.resize, img.data, static_cast<int>(img.stride), out.data.data(), new_width * img.channels);
+    if (!stbir_resize_extended(&s.resize))
+    {
+        throw std::runtime_error("Image resizing failed using stb_image_resize2 (extended).");
+    }
+}
+
 // Convert an RGB image to grayscale using standard luminance weights.
-// img: The input Image struct. Assumes at least 3 channels (RGB).
+// img: The input pixels. 1- and 2-channel images (luma, luma+alpha) are copied through.
+// background: If non-null, the alpha channel of 2- and 4-channel images is composited over this RGB color.
 // Returns: A vector containing the grayscale value (0-255) for each pixel.
-// Returns an empty vector or vector of zeros if the image doesn't have enough channels.
-std::vector<uint8_t> rgbToGrayscale(const Image &img)
+std::vector<uint8_t> rgbToGrayscale(const ImageView &img, const uint8_t *background)
 {
-    // Check if the image has enough channels for RGB conversion
+    std::vector<uint8_t> grayscale(static_cast<size_t>(img.width) * static_cast<size_t>(img.height)); // Vector to store grayscale values, use static_cast
+    const size_t channels = static_cast<size_t>(img.channels);
+    const bool has_alpha = background != nullptr && (img.channels == 2 || img.channels == 4);
+
+    // Images decoded as luma already hold the grayscale value in their first channel
     if (img.channels < 3)
     {
-        // If not, print a warning and return a default grayscale representation (all zeros)
-        std::cerr << "Warning: Image does not have enough channels (" << img.channels << ") for RGB to Grayscale conversion. Expected 3 or more." << std::endl;
-        return std::vector<uint8_t>(static_cast<size_t>(img.width) * static_cast<size_t>(img.height), 0); // Return black/zero grayscale, use static_cast
+        // Luma of the background, used when compositing luma + alpha
+        const uint8_t bg_gray = has_alpha ? static_cast<uint8_t>(constants::GRAYSCALE_WEIGHT_R * background[0] +
+                                                                 constants::GRAYSCALE_WEIGHT_G * background[1] +
+                                                                 constants::GRAYSCALE_WEIGHT_B * background[2])
+                                          : 0;
+        for (int y = 0; y < img.height; y++)
+        {
+            const uint8_t *row = img.row(y);
+            uint8_t *out = grayscale.data() + static_cast<size_t>(y) * static_cast<size_t>(img.width);
+            for (size_t x = 0; x < static_cast<size_t>(img.width); x++)
+            {
+                uint8_t gray = row[x * channels];
+                out[x] = has_alpha ? compositeOver(gray, bg_gray, row[x * channels + 1]) : gray;
+            }
+        }
+        return grayscale;
     }
 
-    std::vector<uint8_t> grayscale(static_cast<size_t>(img.width) * static_cast<size_t>(img.height)); // Vector to store grayscale values, use static_cast
+    const int red = img.redIndex();
+    const int blue = img.blueIndex();
 
     // Iterate through each pixel of the image
     for (int y = 0; y < img.height; y++)
     {
         for (int x = 0; x < img.width; x++)
         {
-            // Calculate the starting index of the current pixel's RGB data
-            size_t i = static_cast<size_t>((y * img.width + x) * img.channels); // Use size_t for index calculation
-
-            // Get the R, G, and B components
-            uint8_t r = img.data[i];
-            uint8_t g = img.data[i + 1];
-            uint8_t b = img.data[i + 2];
+            // Pointer to the current pixel's RGB data
+            const uint8_t *px = img.pixel(x, y);
+
+            // Get the R, G, and B components (BGR frames are read in place)
+            uint8_t r = px[red];
+            uint8_t g = px[1];
+            uint8_t b = px[blue];
+
+            // Blend transparent pixels over the background before taking their luminance
+            if (has_alpha)
+            {
+                uint8_t alpha = px[3];
+                r = compositeOver(r, background[0], alpha);
+                g = compositeOver(g, background[1], alpha);
+                b = compositeOver(b, background[2], alpha);
+            }
 
             // Convert to grayscale using standard luminance weights (Rec. 601) defined as constants
             grayscale[static_cast<size_t>(y * img.width + x)] = static_cast<uint8_t>( // Use size_t for index calculation
@@ -203,32 +521,81 @@ TerminalSize getTerminalSize()
     return size;
 }
 
-// Resize image to fit the current terminal dimensions, adjusting for character aspect ratio.
-// This function calculates the appropriate scale factor to fit the image within the terminal.
-// img: The input Image struct.
-// aspect_ratio: The aspect ratio of characters (width/height).
-// auto_fit: If true, performs the resize; otherwise, returns the original image.
-// Returns: The resized Image struct or the original if auto_fit is false.
-Image resizeImageToTerminal(const Image &img, float aspect_ratio, bool auto_fit)
+// --- Terminal Size Tracking ---
+
+// Bumped by the SIGWINCH handler; lock-free, so it is safe to touch from a signal handler
+static std::atomic<uint64_t> terminal_size_generation{0};
+static std::atomic<bool> terminal_size_tracking{false};
+
+#ifndef _WIN32
+// SIGWINCH handler: only records that the size changed; the next currentTerminalSize() call re-queries it
+static void handleTerminalResize(int)
 {
-    // If auto-fitting is not requested, return the original image without resizing
-    if (!auto_fit)
+    terminal_size_generation.fetch_add(1, std::memory_order_release);
+}
+#endif
+
+// Install the resize handler once
+void startTerminalSizeTracking()
+{
+#ifndef _WIN32
+    bool expected = false;
+    if (!terminal_size_tracking.compare_exchange_strong(expected, true))
     {
-        return img;
+        return;
     }
+    terminal_size_generation.store(1, std::memory_order_release); // Generation 0 means "not tracking"
 
-    // Get the current terminal size
-    TerminalSize term = getTerminalSize();
+    struct sigaction action = {};
+    action.sa_handler = handleTerminalResize;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART; // Don't interrupt writes and sleeps in progress
+    sigaction(SIGWINCH, &action, nullptr);
+#endif
+}
 
+uint64_t terminalSizeGeneration()
+{
+    return terminal_size_generation.load(std::memory_order_acquire);
+}
+
+// Cached terminal size, refreshed when the generation moves on
+TerminalSize currentTerminalSize()
+{
+    if (!terminal_size_tracking.load(std::memory_order_acquire))
+    {
+        return getTerminalSize();
+    }
+
+    static std::mutex cache_mutex;
+    static uint64_t cached_generation = 0;
+    static TerminalSize cached_size = {80, 24};
+
+    // Read the generation before querying: a resize that lands during the query leaves the cache
+    // one generation behind, so the next call queries again
+    uint64_t generation = terminalSizeGeneration();
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (generation != cached_generation)
+    {
+        cached_size = getTerminalSize();
+        cached_generation = generation;
+    }
+    return cached_size;
+}
+
+// Fit an image into the terminal, adjusting for character aspect ratio.
+// This function calculates the appropriate scale factor to fit the image within the terminal.
+void fitToTerminal(int width, int height, float aspect_ratio, const TerminalSize &term, int &new_width, int &new_height)
+{
     // Calculate available terminal height, leaving a small margin for prompts/status
     int terminal_height = term.height > 1 ? term.height - 1 : term.height;
     terminal_height = std::max(terminal_height, 1); // Ensure at least 1
 
     // Calculate the required scale factors based on both width and height to fit within terminal.
     // Scale based on width: (Original width) / (Terminal width in characters)
-    float scale_width = static_cast<float>(img.width) / term.width;
+    float scale_width = static_cast<float>(width) / term.width;
     // Scale based on height: (Original height) / (Terminal height in characters * character aspect ratio)
-    float scale_height = static_cast<float>(img.height) / (static_cast<float>(terminal_height) * aspect_ratio);
+    float scale_height = static_cast<float>(height) / (static_cast<float>(terminal_height) * aspect_ratio);
 
     // Use the LARGER of the two scale factors. This ensures that the image, when scaled by this factor,
     // will fit entirely within the terminal dimensions (width and height).
@@ -241,7 +608,26 @@ Image resizeImageToTerminal(const Image &img, float aspect_ratio, bool auto_fit)
     if (scale > 10000.0f)
         scale = 10000.0f; // Prevent scale from being too large (results in TINY output)
 
-    // Use the generic resizeImage function with the calculated scale and aspect ratio.
-    // Note that resizeImage will re-calculate the new dimensions based on this 'scale' value.
-    return resizeImage(img, scale, aspect_ratio);
+    // Same dimensions resizeImage computes for this scale
+    new_width = static_cast<int>(static_cast<float>(width) / scale);
+    new_height = static_cast<int>(static_cast<float>(height) / scale / aspect_ratio);
+}
+
+// Resize image to fit the current terminal dimensions.
+// img: The input pixels.
+// aspect_ratio: The aspect ratio of characters (width/height).
+// auto_fit: If true, performs the resize; otherwise, returns the original pixels.
+// Returns: A view owning the resized pixels, or the original view (not a copy) if auto_fit is false.
+ImageView resizeImageToTerminal(const ImageView &img, float aspect_ratio, bool auto_fit)
+{
+    // If auto-fitting is not requested, hand back the original pixels without resizing or copying them
+    if (!auto_fit)
+    {
+        return img;
+    }
+
+    int new_width = 0;
+    int new_height = 0;
+    fitToTerminal(img.width, img.height, aspect_ratio, currentTerminalSize(), new_width, new_height);
+    return viewOwning(std::make_shared<Image>(resizeImageTo(img, new_width, new_height)));
 }
\ No newline at end of file
@@ -2,6 +2,15 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <memory>
+
+// Order of the color channels in 3- and 4-channel pixels (alpha is always last).
+// Decoded files are RGB; OpenCV frames are BGR and are read in that order without swizzling them first.
+enum class ChannelOrder
+{
+    RGB,
+    BGR
+};
 
 // Structure to hold image data
 struct Image
@@ -10,11 +19,62 @@ struct Image
     int width;                 // Image width in pixels
     int height;                // Image height in pixels
     int channels;              // Number of color channels per pixel (e.g., 3 for RGB, 4 for RGBA)
+    ChannelOrder order;        // Color channel order of 3- and 4-channel data
 
     // Constructor to initialize members
-    Image() : width(0), height(0), channels(0) {}
+    Image() : width(0), height(0), channels(0), order(ChannelOrder::RGB) {}
 
     // Destructor is implicitly handled by std::vector's destructor
+    // The pipeline moves Images rather than copying them; copies are counted (see imageBytesCopied)
+    Image(const Image &other);
+    Image &operator=(const Image &other);
+    Image(Image &&) = default;
+    Image &operator=(Image &&) = default;
+};
+
+// Read-only view of pixel data owned elsewhere (an Image, a decoder buffer, a memory map, a cv::Mat).
+// Rows may be padded or belong to a larger image, so always step rows by 'stride'.
+// Functions that only read pixels take an ImageView, so crops, video frames and decoder output
+// can be processed without copying them into an Image first.
+struct ImageView
+{
+    const uint8_t *data = nullptr; // First pixel of the first row
+    int width = 0;                 // Width in pixels
+    int height = 0;                // Height in pixels
+    int channels = 0;              // Channels per pixel
+    size_t stride = 0;             // Bytes from the start of one row to the start of the next
+    ChannelOrder order = ChannelOrder::RGB; // Color channel order of 3- and 4-channel data
+
+    // Optional owner of the pixels. Empty for plain views (the viewed memory must outlive the view);
+    // set when the view is the only handle to its pixels (decoder buffers, memory maps, video frames).
+    std::shared_ptr<const void> keep_alive;
+
+    ImageView() = default;
+
+    // View raw pixels; stride 0 means tightly packed rows
+    ImageView(const uint8_t *data, int width, int height, int channels, size_t stride = 0,
+              ChannelOrder order = ChannelOrder::RGB)
+        : data(data), width(width), height(height), channels(channels),
+          stride(stride != 0 ? stride : static_cast<size_t>(width) * static_cast<size_t>(channels)), order(order) {}
+
+    // View an Image's pixels (implicit, so Images can be passed wherever a view is accepted)
+    ImageView(const Image &img) : ImageView(img.data.data(), img.width, img.height, img.channels, 0, img.order) {}
+
+    // Offsets of the red and blue components within a pixel (green is always 1)
+    int redIndex() const { return order == ChannelOrder::BGR ? 2 : 0; }
+    int blueIndex() const { return order == ChannelOrder::BGR ? 0 : 2; }
+
+    // Pointer to the first byte of row y
+    const uint8_t *row(int y) const { return data + static_cast<size_t>(y) * stride; }
+
+    // Pointer to the first channel of pixel (x, y)
+    const uint8_t *pixel(int x, int y) const { return row(y) + static_cast<size_t>(x) * static_cast<size_t>(channels); }
+
+    // True if rows follow each other without padding
+    bool isPacked() const { return stride == static_cast<size_t>(width) * static_cast<size_t>(channels); }
+
+    // Sub-rectangle sharing the same pixels (and owner); the rectangle is clamped to the view
+    ImageView crop(int x, int y, int crop_width, int crop_height) const;
 };
 
 // Structure to hold terminal dimensions
@@ -24,36 +84,120 @@ struct TerminalSize
     int height; // Terminal height in characters
 };
 
+// Blend a straight (non-premultiplied) color component over a background component.
+// c: Foreground component (0-255), bg: background component (0-255), alpha: foreground coverage (0-255).
+// Returns: The composited component, rounded to nearest.
+inline uint8_t compositeOver(uint8_t c, uint8_t bg, uint8_t alpha)
+{
+    return static_cast<uint8_t>((c * alpha + bg * (255 - alpha) + 127) / 255);
+}
+
 // --- Function Declarations ---
 
+// Read a whole file into memory.
+// path: The path to the file.
+// bytes: Receives the file contents; its existing capacity is reused.
+// Returns: true on success, false if the file can't be opened or read (bytes is then unspecified).
+bool readFileBytes(const std::string &path, std::vector<uint8_t> &bytes);
+
 // Load an image from a file path using stb_image.
 // path: The path to the image file.
-// Returns: An Image struct containing the loaded image data and dimensions.
+// desired_channels: Channel count to decode into (1 = luma, 3 = RGB, 4 = RGBA), or 0 to keep the file's own count.
+//                   Decoding straight into the channel count the renderer needs keeps unused data out of every later stage.
+// Returns: A view of the decoded pixels that owns the decoder's buffer (no copy is made).
 // Throws: std::runtime_error if the image fails to load.
-Image loadImage(const std::string &path);
+// Note: 16-bit and Radiance HDR files are decoded at full precision and rescaled/tone-mapped to 8 bits.
+ImageView loadImage(const std::string &path, int desired_channels = 0);
+
+// Decode an image that is already in memory (e.g. read ahead by batch mode).
+// bytes, size: The encoded file contents.
+// desired_channels: As for loadImage.
+// Returns: A view of the decoded 8-bit pixels that owns the decoder's buffer.
+// Throws: std::runtime_error with stb_image's failure reason if decoding fails, or if size is over INT_MAX bytes.
+ImageView loadImageFromMemory(const uint8_t *bytes, size_t size, int desired_channels = 0);
+
+// Copy a view's pixels into a tightly packed Image.
+// Only needed where an owned, modifiable copy is really required.
+Image copyImage(const ImageView &view);
+
+// Total pixel bytes copied by copyImage and Image copies so far (all threads).
+// Tests use it to check that frames go from decoder to renderer without being copied.
+uint64_t imageBytesCopied();
 
 // Resize an image using a scale factor and adjust height based on character aspect ratio.
-// img: The input Image struct.
+// img: The input pixels.
 // scale: A scaling factor (e.g., 1.0 for no scaling, 0.5 for half size).
 // aspect_ratio: The aspect ratio (width/height) of characters used for output.
 // Returns: A new Image struct with the resized image data.
 // Note: Uses nearest-neighbor interpolation in the current implementation (see .cpp for details).
-Image resizeImage(const Image &img, float scale, float aspect_ratio);
+Image resizeImage(const ImageView &img, float scale, float aspect_ratio);
+
+// Resize an image to exact pixel dimensions.
+// img: The input pixels. Images with an alpha channel (2 or 4 channels) are filtered alpha-weighted.
+// new_width, new_height: Target dimensions in pixels (clamped to at least 1x1).
+// Returns: A new Image struct with the resized image data.
+Image resizeImageTo(const ImageView &img, int new_width, int new_height);
+
+// A resize from one fixed geometry to another, prepared once and run on many images (video frames).
+// Building the filter samplers is a large part of resizing a frame down to terminal size, so the plan
+// keeps them, and callers keep the output buffer, until the source or target dimensions change.
+// Not thread-safe: use one plan per thread.
+class ResizePlan
+{
+public:
+    ResizePlan();
+    ~ResizePlan();
+    ResizePlan(const ResizePlan &) = delete;
+    ResizePlan &operator=(const ResizePlan &) = delete;
+
+    // Resize img to exact pixel dimensions into 'out', reusing out's buffer.
+    // Results are the same as resizeImageTo; the samplers are only rebuilt when the dimensions
+    // or channel count differ from the previous call.
+    // Throws: std::runtime_error if resizing fails.
+    void resize(const ImageView &img, int new_width, int new_height, Image &out);
+
+    // Number of times the samplers have been built
+    uint64_t rebuilds() const { return rebuild_count; }
+
+private:
+    struct State; // stb_image_resize2 state, kept out of this header
+    std::unique_ptr<State> state;
+    uint64_t rebuild_count = 0;
+};
 
 // Convert an RGB image to grayscale.
-// img: The input Image struct (expected to have at least 3 channels).
-// Returns: A vector of uint8_t containing the grayscale values (0-255) for each pixel.
-// Returns an empty vector or vector of zeros if the image doesn't have enough channels.
-std::vector<uint8_t> rgbToGrayscale(const Image &img);
+// img: The input pixels. Images with 1 or 2 channels are already luma and are copied through.
+// background: Optional RGB color to composite the alpha channel (2 or 4 channel images) against.
+// Returns: A vector of uint8_t containing the grayscale values (0-255) for each pixel, tightly packed.
+std::vector<uint8_t> rgbToGrayscale(const ImageView &img, const uint8_t *background = nullptr);
 
 // Get the current size of the terminal window.
 // Returns: A TerminalSize struct with the width and height in characters.
 // Provides a default size if terminal size cannot be determined.
 TerminalSize getTerminalSize();
 
+// Follow terminal resizes from now on: installs a SIGWINCH handler (once per process) that bumps
+// the terminal size generation. A no-op where the platform has no resize signal.
+void startTerminalSizeTracking();
+
+// Counter that changes whenever the terminal is resized (0 while tracking hasn't started).
+// Per-size resources (resize plans, buffers, output grids) can be kept as long as it stays the same.
+uint64_t terminalSizeGeneration();
+
+// The terminal size, re-queried only after a resize once tracking has started
+// (before that, or without a resize signal, every call queries the terminal).
+TerminalSize currentTerminalSize();
+
+// Output dimensions that fit an image into the terminal (one line is left for the prompt).
+// width, height: Source image dimensions in pixels.
+// aspect_ratio: The aspect ratio of characters used for output.
+// term: Terminal size in characters.
+// new_width, new_height: Receive the target dimensions, as resizeImageToTerminal would resize to.
+void fitToTerminal(int width, int height, float aspect_ratio, const TerminalSize &term, int &new_width, int &new_height);
+
 // Resize an image to fit the current terminal dimensions.
-// img: The input Image struct.
+// img: The input pixels.
 // aspect_ratio: The aspect ratio of characters used for output.
-// auto_fit: Boolean flag indicating if auto-fitting is enabled. If false, returns the original image.
-// Returns: A new Image struct resized to fit the terminal, or the original image if auto_fit is false.
-Image resizeImageToTerminal(const Image &img, float aspect_ratio, bool auto_fit);
\ No newline at end of file
+// auto_fit: Boolean flag indicating if auto-fitting is enabled. If false, 'img' itself is returned (no copy).
+// Returns: A view of the resized pixels, which it owns, or of the original pixels if auto_fit is false.
+ImageView resizeImageToTerminal(const ImageView &img, float aspect_ratio, bool auto_fit);
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "image.h"
 #include "ascii_art.h"
+#include "batch.h"
+#include "video.h"
+#include "ascii_video.h"
+#include "asciicast.h"
+#include "text_export.h"
 #include <iostream>
 #include <string>
 #include <stdexcept>
@@ -7,6 +12,7 @@
 #include <filesystem>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
 
 // check if a string is a URL
 bool isURL(const std::string &input)
@@ -159,16 +165,97 @@ std::string downloadFromURL(const std::string &url)
     return tempFile;
 }
 
+// Parse a color given as a hex triplet (#rrggbb, rrggbb, #rgb) or a basic color name
+// input: The color string from the command line
+// color: Receives the parsed RGB values on success
+// Returns: true if the color was recognized, false otherwise
+bool parseColor(const std::string &input, std::array<uint8_t, 3> &color)
+{
+    std::string value = input;
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+
+    // Named colors
+    if (value == "black")
+    {
+        color = {0, 0, 0};
+        return true;
+    }
+    if (value == "white")
+    {
+        color = {255, 255, 255};
+        return true;
+    }
+    if (value == "gray" || value == "grey")
+    {
+        color = {128, 128, 128};
+        return true;
+    }
+
+    if (!value.empty() && value[0] == '#')
+    {
+        value = value.substr(1);
+    }
+
+    // Expand the short #rgb form to #rrggbb
+    if (value.length() == 3)
+    {
+        value = std::string{value[0], value[0], value[1], value[1], value[2], value[2]};
+    }
+
+    if (value.length() != 6 || value.find_first_not_of("0123456789abcdef") != std::string::npos)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        color[i] = static_cast<uint8_t>(std::stoi(value.substr(i * 2, 2), nullptr, 16));
+    }
+    return true;
+}
+
 // Function to display the command-line usage help message
 // program_name: The name of the executable (argv[0])
+// Choose where an exported video goes from the output options: a recording or a text file by the output
+// path's extension, or one text file per frame in the output directory
+// input_path: The video (names the recording and the per-frame files)
+// output_path: -o, or empty
+// output_dir: --output-dir, or empty
+// Returns: The sink to export into, or null to play the video in the terminal
+// Throws: std::runtime_error if the output can't be created
+std::unique_ptr<FrameSink> createVideoSink(const std::string &input_path, const std::string &output_path,
+                                           const std::string &output_dir)
+{
+    const std::filesystem::path input(input_path);
+    if (isAsciicastFile(output_path))
+    {
+        return std::make_unique<AsciicastWriter>(output_path, input.filename().string());
+    }
+    if (isAsciiVideoFile(output_path))
+    {
+        return std::make_unique<AsciiVideoWriter>(output_path);
+    }
+    if (!output_path.empty())
+    {
+        return std::make_unique<FramedTextWriter>(output_path);
+    }
+    if (!output_dir.empty())
+    {
+        return std::make_unique<TextFrameFilesWriter>(output_dir, input.stem().string());
+    }
+    return nullptr;
+}
+
 void displayHelp(const char *program_name)
 {
-    std::cout << "Usage: " << program_name << " -i <input> [options]\n\n";
+    std::cout << "Usage: " << program_name << " -i <input> [options]\n";
+    std::cout << "       " << program_name << " --batch <dir|glob|list> --output-dir <dir> [options]\n\n";
     std::cout << "Required:\n";
     std::cout << "  -i, --input <path|url>      Path to input media file or URL\n";
+    std::cout << "      --batch <source>        Convert many images: a directory, a quoted glob, or a file listing paths\n";
     std::cout << "\n";
     std::cout << "Options:\n";
-    std::cout << "  -o, --output <path>         Path to save output ASCII art\n";
+    std::cout << "  -o, --output <path>         Path to save output ASCII art (.cast: asciicast v2 recording; .pxv: replayable video)\n";
     std::cout << "  -c, --color                 Enable colored ASCII output using ANSI escape codes\n";
     std::cout << "  -g, --original              Display media at original resolution\n";
     std::cout << "  -s, --scale <float>         Scale media (default: 1.0) (ignored unless --original is used)\n";
@@ -177,7 +264,23 @@ void displayHelp(const char *program_name)
     std::cout << "  -n, --invert                Invert brightness mapping\n";
     std::cout << "  -e, --edges                 Detect edges instead of brightness for character selection\n";
     std::cout << "  -m, --chars <string>        ASCII character set (default: \" .:-=+*#%@\")\n";
-    std::cout << "  -d, --delay <ms>            Frame delay in milliseconds for videos (default: auto)\n";
+    std::cout << "      --background <color>    Composite transparent images over a color (#rrggbb, white, black, gray)\n";
+    std::cout << "  -d, --delay <ms|auto>       Frame delay in milliseconds for videos (default: auto, the file's timing)\n";
+    std::cout << "      --no-drop               Play every video frame even when rendering falls behind\n";
+    std::cout << "      --stats                 Print per-stage timings, latency, queue depths and bytes per frame after video playback;\n"
+              << "                              cache hits and misses after an image\n";
+    std::cout << "      --verify-output         Debug: replay video output into a virtual screen and check every frame\n";
+    std::cout << "      --max-bytes-per-sec <n> Limit video output bandwidth, lowering color, grid size and update rate to fit\n";
+    std::cout << "      --render-budget <ms|auto> Video render time per frame; edges, resize filter, color and grid size give way to keep up\n";
+    std::cout << "      --start <seconds>       Start playing a recorded .pxv video at this time\n";
+    std::cout << "      --output-dir <dir>      Directory for batch output files (required with --batch), or one text file per video frame\n";
+    std::cout << "      --max-in-flight <n>     Most video frames decoded or rendered ahead at once (bounds memory; default: 4 per worker)\n";
+    std::cout << "      --segments <n>          Split a video export into n parts decoded and rendered at once\n";
+    std::cout << "  -j, --jobs <n>              Worker threads for batch mode and video rendering (default: all cores; video playback: up to 4)\n";
+    std::cout << "      --cache-dir <dir>       Reuse rendered output for unchanged images and settings\n";
+    std::cout << "      --cache-size <MB>       Output cache size limit, least recently used evicted first (default: 256)\n";
+    std::cout << "      --pixel-cache <dir>     Keep decoded pixels to skip decoding when re-rendering a source\n";
+    std::cout << "      --pixel-cache-size <MB> Decoded-pixel cache size limit (default: 1024)\n";
     std::cout << "  -h, --help                  Show this help message\n";
     std::cout << "\n";
     std::cout << "Examples:\n";
@@ -185,6 +288,8 @@ void displayHelp(const char *program_name)
     std::cout << "  " << program_name << " -i video.mp4\n";
     std::cout << "  " << program_name << " -i https://example.com/image.jpg -c\n";
     std::cout << "  " << program_name << " -i large_image.png -g -s 0.5\n";
+    std::cout << "  " << program_name << " -i logo.png -c --background white\n";
+    std::cout << "  " << program_name << " --batch 'frames/*.png' --output-dir ascii/ -j 8\n";
 }
 
 // Main function - entry point of the program
@@ -192,10 +297,21 @@ void displayHelp(const char *program_name)
 int main(int argc, char *argv[])
 {
     AsciiArtParams params; // Create a struct to hold parsed parameters
-    int frameDelay = 100;
+    int frameDelay = VideoOptions::AUTO_DELAY;
     std::string originalInput;
     std::string tempFile;
     bool isTemporaryFile = false;
+    std::string batchSource;
+    std::string batchOutputDir;
+    unsigned int batchJobs = 0; // Batch workers and video render workers; 0 = pick from the hardware
+    bool showStats = false;
+    bool dropLateFrames = true;
+    bool verifyOutput = false;
+    size_t maxBytesPerSec = 0; // Video output budget; 0 = unlimited
+    size_t maxInFlight = 0;    // Video frames decoded or rendered ahead at once; 0 = a few per render worker
+    size_t segments = 1;       // Parts a video export is split into and decoded in parallel
+    double renderBudgetMs = 0.0; // Video render time budget per frame; 0 = none
+    double startSeconds = 0.0;   // Where playback of a recorded video starts
 
     try
     {
@@ -392,8 +508,10 @@ int main(int argc, char *argv[])
                 {
                     try
                     {
-                        frameDelay = std::stoi(argv[++i]); // Convert next arg to int and assign
-                        if (frameDelay < 0)
+                        std::string delay = argv[++i];
+                        // "auto" follows the file's own timing; anything else is a delay in milliseconds
+                        frameDelay = (delay == "auto") ? VideoOptions::AUTO_DELAY : std::stoi(delay);
+                        if (delay != "auto" && frameDelay < 0)
                         {
                             std::cerr << "Error: Frame delay must be non-negative." << std::endl;
                             displayHelp(argv[0]);
@@ -406,7 +524,7 @@ int main(int argc, char *argv[])
                     }
                     catch (const std::invalid_argument &ia)
                     {
-                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected an integer." << std::endl;
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected an integer or 'auto'." << std::endl;
                         displayHelp(argv[0]);
                         if (isTemporaryFile && !tempFile.empty())
                         {
@@ -436,6 +554,309 @@ int main(int argc, char *argv[])
                     return 1;
                 }
             }
+            else if (arg == "--batch")
+            {
+                if (i + 1 < argc)
+                {
+                    batchSource = argv[++i];
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (directory, glob or list file)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--output-dir")
+            {
+                if (i + 1 < argc)
+                {
+                    batchOutputDir = argv[++i];
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (output directory)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "-j" || arg == "--jobs")
+            {
+                if (i + 1 < argc)
+                {
+                    try
+                    {
+                        int jobs = std::stoi(argv[++i]);
+                        if (jobs < 1)
+                        {
+                            std::cerr << "Error: Number of jobs must be at least 1." << std::endl;
+                            return 1;
+                        }
+                        batchJobs = static_cast<unsigned int>(jobs);
+                    }
+                    catch (const std::exception &)
+                    {
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected an integer." << std::endl;
+                        displayHelp(argv[0]);
+                        return 1;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (number of jobs)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--max-bytes-per-sec")
+            {
+                if (i + 1 < argc)
+                {
+                    try
+                    {
+                        long long rate = std::stoll(argv[++i]);
+                        if (rate < 1)
+                        {
+                            std::cerr << "Error: Bytes per second must be at least 1." << std::endl;
+                            return 1;
+                        }
+                        maxBytesPerSec = static_cast<size_t>(rate);
+                    }
+                    catch (const std::exception &)
+                    {
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected an integer." << std::endl;
+                        displayHelp(argv[0]);
+                        return 1;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (bytes per second)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--max-in-flight")
+            {
+                if (i + 1 < argc)
+                {
+                    try
+                    {
+                        long long frames = std::stoll(argv[++i]);
+                        if (frames < 2)
+                        {
+                            std::cerr << "Error: Frames in flight must be at least 2 (one decoded, one rendered)." << std::endl;
+                            return 1;
+                        }
+                        maxInFlight = static_cast<size_t>(frames);
+                    }
+                    catch (const std::exception &)
+                    {
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected an integer." << std::endl;
+                        displayHelp(argv[0]);
+                        return 1;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (frames)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--segments")
+            {
+                if (i + 1 < argc)
+                {
+                    try
+                    {
+                        long long parts = std::stoll(argv[++i]);
+                        if (parts < 1)
+                        {
+                            std::cerr << "Error: Segments must be at least 1." << std::endl;
+                            return 1;
+                        }
+                        segments = static_cast<size_t>(parts);
+                    }
+                    catch (const std::exception &)
+                    {
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected an integer." << std::endl;
+                        displayHelp(argv[0]);
+                        return 1;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (number of segments)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--start")
+            {
+                if (i + 1 < argc)
+                {
+                    try
+                    {
+                        startSeconds = std::stod(argv[++i]);
+                        if (startSeconds < 0)
+                        {
+                            std::cerr << "Error: Start time cannot be negative." << std::endl;
+                            return 1;
+                        }
+                    }
+                    catch (const std::exception &)
+                    {
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected seconds." << std::endl;
+                        displayHelp(argv[0]);
+                        return 1;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (seconds)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--render-budget")
+            {
+                if (i + 1 < argc)
+                {
+                    try
+                    {
+                        std::string budget = argv[++i];
+                        // "auto" is whatever keeps up with the video's frame rate
+                        renderBudgetMs = (budget == "auto") ? VideoOptions::AUTO_RENDER_BUDGET : std::stod(budget);
+                        if (budget != "auto" && renderBudgetMs <= 0)
+                        {
+                            std::cerr << "Error: Render budget must be positive." << std::endl;
+                            return 1;
+                        }
+                    }
+                    catch (const std::exception &)
+                    {
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected milliseconds or 'auto'." << std::endl;
+                        displayHelp(argv[0]);
+                        return 1;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (milliseconds or 'auto')." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--cache-dir")
+            {
+                if (i + 1 < argc)
+                {
+                    params.cache_dir = argv[++i];
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (cache directory)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--cache-size")
+            {
+                if (i + 1 < argc)
+                {
+                    try
+                    {
+                        float megabytes = std::stof(argv[++i]);
+                        if (megabytes <= 0)
+                        {
+                            std::cerr << "Error: Cache size must be positive." << std::endl;
+                            return 1;
+                        }
+                        params.cache_max_bytes = static_cast<uint64_t>(megabytes * 1024.0f * 1024.0f);
+                    }
+                    catch (const std::exception &)
+                    {
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected a number." << std::endl;
+                        displayHelp(argv[0]);
+                        return 1;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (size in megabytes)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--pixel-cache")
+            {
+                if (i + 1 < argc)
+                {
+                    params.pixel_cache_dir = argv[++i];
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (cache directory)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--pixel-cache-size")
+            {
+                if (i + 1 < argc)
+                {
+                    try
+                    {
+                        float megabytes = std::stof(argv[++i]);
+                        if (megabytes <= 0)
+                        {
+                            std::cerr << "Error: Cache size must be positive." << std::endl;
+                            return 1;
+                        }
+                        params.pixel_cache_max_bytes = static_cast<uint64_t>(megabytes * 1024.0f * 1024.0f);
+                    }
+                    catch (const std::exception &)
+                    {
+                        std::cerr << "Error: Invalid argument for option '" << arg << "'. Expected a number." << std::endl;
+                        displayHelp(argv[0]);
+                        return 1;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (size in megabytes)." << std::endl;
+                    displayHelp(argv[0]);
+                    return 1;
+                }
+            }
+            else if (arg == "--background")
+            {
+                if (i + 1 < argc)
+                {
+                    if (!parseColor(argv[++i], params.background))
+                    {
+                        std::cerr << "Error: Invalid color for option '" << arg << "'. Expected #rrggbb or a color name." << std::endl;
+                        displayHelp(argv[0]);
+                        if (isTemporaryFile && !tempFile.empty())
+                        {
+                            std::filesystem::remove(tempFile);
+                        }
+                        return 1;
+                    }
+                    params.composite_alpha = true;
+                }
+                else
+                {
+                    std::cerr << "Error: Option '" << arg << "' requires an argument (background color)." << std::endl;
+                    displayHelp(argv[0]);
+                    if (isTemporaryFile && !tempFile.empty())
+                    {
+                        std::filesystem::remove(tempFile);
+                    }
+                    return 1;
+                }
+            }
             // Boolean flags
             else if (arg == "-g" || arg == "--original")
             {
@@ -453,6 +874,18 @@ int main(int argc, char *argv[])
             {
                 params.detect_edges = true; // Set the detect_edges flag
             }
+            else if (arg == "--stats")
+            {
+                showStats = true; // Report per-frame timings after video playback, cache use after an image
+            }
+            else if (arg == "--no-drop")
+            {
+                dropLateFrames = false; // Play every video frame even when running late
+            }
+            else if (arg == "--verify-output")
+            {
+                verifyOutput = true; // Check the bytes sent for every video frame against a virtual screen
+            }
             else if (arg == "-h" || arg == "--help")
             {
                 displayHelp(argv[0]); // Display help and exit
@@ -473,8 +906,23 @@ int main(int argc, char *argv[])
         // --- End Command Line Parsing ---
 
         // --- Parameter Validation ---
+        // Batch mode takes its inputs from --batch instead of --input
+        if (!batchSource.empty() && !params.input_path.empty())
+        {
+            std::cerr << "Error: --batch and --input cannot be used together." << std::endl;
+            if (isTemporaryFile && !tempFile.empty())
+            {
+                std::filesystem::remove(tempFile);
+            }
+            return 1;
+        }
+        if (!batchSource.empty() && batchOutputDir.empty())
+        {
+            std::cerr << "Error: Batch mode requires an output directory (--output-dir)." << std::endl;
+            return 1;
+        }
         // Check if the required input path was provided
-        if (params.input_path.empty())
+        if (params.input_path.empty() && batchSource.empty())
         {
             std::cerr << "Error: Input file path or URL is required (--input or -i option)." << std::endl;
             std::cerr << "Use -h or --help for usage information." << std::endl;
@@ -516,11 +964,65 @@ int main(int argc, char *argv[])
         // --- End Parameter Validation ---
 
         // --- File Type Detection and Processing ---
+        // Batch mode converts every collected image into the output directory
+        if (!batchSource.empty())
+        {
+            std::vector<std::string> inputs = collectBatchInputs(batchSource);
+            if (inputs.empty())
+            {
+                std::cerr << "Error: No input images found in '" << batchSource << "'." << std::endl;
+                return 1;
+            }
+            return processBatch(inputs, batchOutputDir, params, batchJobs) ? 0 : 1;
+        }
+        // A recorded ASCII video is played back as stored, with no decoding or rendering
+        else if (isAsciiVideoFile(params.input_path))
+        {
+            VideoOptions videoOptions;
+            videoOptions.frame_delay = frameDelay;
+            videoOptions.show_stats = showStats;
+            videoOptions.start_seconds = startSeconds;
+            return playAsciiVideo(params.input_path, videoOptions) ? 0 : 1;
+        }
         // Determine if input is video/GIF or static image and process accordingly
-        if (isVideoFile(params.input_path))
+        else if (isVideoFile(params.input_path))
         {
             // Process video/GIF
-            if (!processVideo(params.input_path, params, frameDelay))
+            VideoOptions videoOptions;
+            videoOptions.frame_delay = frameDelay;
+            videoOptions.show_stats = showStats;
+            videoOptions.render_workers = batchJobs;
+            videoOptions.drop_late_frames = dropLateFrames;
+            videoOptions.verify_output = verifyOutput;
+            videoOptions.max_bytes_per_sec = maxBytesPerSec;
+            videoOptions.max_in_flight = maxInFlight;
+            videoOptions.segments = segments;
+            videoOptions.render_budget_ms = renderBudgetMs;
+            bool ok;
+            if (!params.output_path.empty() || !batchOutputDir.empty())
+            {
+                // Export to files instead of playing: every frame, as fast as it renders
+                try
+                {
+                    std::unique_ptr<FrameSink> sink = createVideoSink(params.input_path, params.output_path, batchOutputDir);
+                    ok = exportVideo(params.input_path, params, videoOptions, *sink);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    ok = false;
+                }
+            }
+            else if (segments > 1)
+            {
+                std::cerr << "Error: --segments only applies when exporting a video (-o or --output-dir)." << std::endl;
+                ok = false;
+            }
+            else
+            {
+                ok = processVideo(params.input_path, params, videoOptions);
+            }
+            if (!ok)
             {
                 std::cerr << "Error: Failed to process video file." << std::endl;
                 if (isTemporaryFile && !tempFile.empty())
@@ -533,7 +1035,7 @@ int main(int argc, char *argv[])
         else
         {
             // Process static image using existing function
-            processImage(params);
+            processImage(params, showStats);
         }
         // --- End File Type Detection and Processing ---
 
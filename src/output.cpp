@@ -1,7 +1,25 @@
 #include "output.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <fstream>
+#include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
 
 // Save the generated ASCII text to a file.
 // ascii_text: The string containing the ASCII art.
@@ -25,4 +43,209 @@ void saveOutputText(const std::string &ascii_text, const std::string &output_pat
     // Close the file stream. This is important to ensure data is written and resources are released.
     // The file is also automatically closed when the ofstream object goes out of scope.
     file.close();
-}
\ No newline at end of file
+}
+
+// Write a buffer to standard output with as few system calls as the kernel allows.
+// Returns the number of write() calls, so callers can report syscalls per frame.
+size_t writeStdout(const char *data, size_t size)
+{
+    std::cout.flush(); // Anything already queued in iostreams goes first
+
+    size_t calls = 0;
+    while (size > 0)
+    {
+#ifdef _WIN32
+        int written = _write(1, data, static_cast<unsigned int>(size));
+#else
+        ssize_t written = write(STDOUT_FILENO, data, size);
+#endif
+        calls++;
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+#ifndef _WIN32
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                // Non-blocking output (set by another program sharing the terminal): wait until it drains
+                struct pollfd pfd = {STDOUT_FILENO, POLLOUT, 0};
+                poll(&pfd, 1, -1);
+                continue;
+            }
+#endif
+            throw std::runtime_error(std::string("Failed to write to standard output: ") + std::strerror(errno));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return calls;
+}
+
+// Ask the tty driver how much of our output is still queued
+size_t pendingStdoutBytes()
+{
+#if defined(TIOCOUTQ)
+    int queued = 0;
+    if (ioctl(STDOUT_FILENO, TIOCOUTQ, &queued) == 0 && queued > 0)
+    {
+        return static_cast<size_t>(queued);
+    }
+#elif defined(FIONWRITE)
+    int queued = 0;
+    if (ioctl(STDOUT_FILENO, FIONWRITE, &queued) == 0 && queued > 0)
+    {
+        return static_cast<size_t>(queued);
+    }
+#endif
+    return 0;
+}
+
+#ifndef _WIN32
+// True once a primary device attributes answer (CSI ? <params> c) is in the reply
+static bool hasDeviceAttributes(const std::string &reply)
+{
+    for (size_t start = reply.find("\033[?"); start != std::string::npos; start = reply.find("\033[?", start + 1))
+    {
+        size_t end = reply.find_first_not_of("0123456789;", start + 3);
+        if (end != std::string::npos && reply[end] == 'c')
+        {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+// Query mode 2026 on the controlling terminal and parse the DECRQM answer (CSI ? 2026 ; <state> $ y)
+bool querySynchronizedUpdates(int timeout_ms)
+{
+#ifdef _WIN32
+    (void)timeout_ms;
+    return false;
+#else
+    if (!isatty(STDOUT_FILENO))
+    {
+        return false;
+    }
+    int fd = open("/dev/tty", O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct termios saved;
+    if (tcgetattr(fd, &saved) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // Read the answer byte by byte as it arrives, without echoing it
+    struct termios raw = saved;
+    raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &raw);
+
+    std::string reply;
+    const char query[] = "\033[?2026$p\033[c";
+    if (write(fd, query, sizeof(query) - 1) == static_cast<ssize_t>(sizeof(query) - 1))
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (!hasDeviceAttributes(reply))
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0)
+            {
+                break;
+            }
+            struct pollfd pfd = {fd, POLLIN, 0};
+            int ready = poll(&pfd, 1, static_cast<int>(remaining.count()));
+            if (ready < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (ready <= 0)
+            {
+                break;
+            }
+            char buffer[256];
+            ssize_t got = read(fd, buffer, sizeof(buffer));
+            if (got <= 0)
+            {
+                break;
+            }
+            reply.append(buffer, static_cast<size_t>(got));
+        }
+    }
+
+    tcsetattr(fd, TCSANOW, &saved);
+    close(fd);
+
+    // State 1 (set) or 2 (reset) means the mode is recognized and can be switched; 3 means it is always on.
+    // 0 (unknown) and 4 (permanently off) mean no synchronized updates.
+    size_t answer = reply.find("\033[?2026;");
+    const size_t prefix = 8; // ESC [ ? 2 0 2 6 ;
+    if (answer == std::string::npos || answer + prefix + 3 > reply.size())
+    {
+        return false;
+    }
+    char state = reply[answer + prefix];
+    return (state == '1' || state == '2' || state == '3') && reply.compare(answer + prefix + 1, 2, "$y") == 0;
+#endif
+}
+
+// Map the whole file read-only; Windows builds read it into a buffer instead
+bool readOnlyFile(const std::string &path, ReadOnlyFile &file)
+{
+    file = ReadOnlyFile();
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+    {
+        return false;
+    }
+    std::streamoff size = in.tellg();
+    if (size < 0)
+    {
+        return false;
+    }
+    auto buffer = std::make_shared<std::vector<char>>(static_cast<size_t>(size));
+    in.seekg(0);
+    if (size > 0 && !in.read(buffer->data(), size))
+    {
+        return false;
+    }
+    file.size = static_cast<size_t>(size);
+    file.data = std::shared_ptr<const void>(buffer, buffer->data());
+    return true;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < 0)
+    {
+        close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0)
+    {
+        close(fd); // Nothing to map
+        return true;
+    }
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    file.size = size;
+    file.data = std::shared_ptr<const void>(mapped, [size](const void *p) { munmap(const_cast<void *>(p), size); });
+    return true;
+#endif
+}
@@ -1,12 +1,56 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
+// The contents of a file, read-only, for as long as any copy of 'data' is kept
+struct ReadOnlyFile
+{
+    std::shared_ptr<const void> data; // Start of the contents (null for an empty file); releases them when the last copy goes
+    size_t size = 0;
+
+    const char *bytes() const { return static_cast<const char *>(data.get()); }
+};
+
 // --- Function Declarations ---
 
 // Saves a string of text to a specified file path.
 // ascii_text: The string content to save.
 // output_path: The path to the output file.
 // Throws: std::runtime_error if the file cannot be opened for writing.
-void saveOutputText(const std::string &ascii_text, const std::string &output_path);
\ No newline at end of file
+void saveOutputText(const std::string &ascii_text, const std::string &output_path);
+
+// Writes a buffer to standard output with direct write() calls, bypassing iostreams (std::cout is flushed first
+// so earlier output stays in order). The kernel normally takes the whole buffer in one call, so a terminal
+// receives a frame at once; partial writes and interrupted calls are continued.
+// data, size: The bytes to write.
+// Returns: The number of write() calls made.
+// Throws: std::runtime_error if writing fails.
+size_t writeStdout(const char *data, size_t size);
+
+// Writes a string to standard output in as few write() calls as possible (see above).
+inline size_t writeStdout(const std::string &bytes) { return writeStdout(bytes.data(), bytes.size()); }
+
+// Bytes written to standard output that the terminal hasn't read yet (TIOCOUTQ).
+// A queue that doesn't drain between frames means the terminal, or the connection behind it, can't keep up.
+// Returns: The queued byte count, or 0 if standard output is not a terminal or the platform can't tell.
+size_t pendingStdoutBytes();
+
+// Asks the terminal whether it supports synchronized updates (DEC private mode 2026), which let a frame be
+// drawn without the terminal repainting halfway through it.
+// Sends a DECRQM query (CSI ? 2026 $ p) followed by a primary device attributes request (CSI c), which every
+// terminal answers, so terminals that ignore DECRQM are recognized as soon as that answer arrives.
+// The controlling terminal is switched to non-canonical, no-echo input while waiting and restored afterwards.
+// timeout_ms: How long to wait for the answers at most.
+// Returns: true if the terminal recognizes mode 2026; false if it doesn't, doesn't answer in time,
+//          or standard output is not a terminal.
+bool querySynchronizedUpdates(int timeout_ms);
+
+// Opens a file for reading in place: memory-mapped on POSIX systems, so only the pages that are touched are read
+// and nothing is copied; read into memory on Windows.
+// path: The file.
+// file: Receives the contents.
+// Returns: false if the file can't be opened, mapped or read.
+bool readOnlyFile(const std::string &path, ReadOnlyFile &file);
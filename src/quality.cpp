@@ -0,0 +1,229 @@
+#include "quality.h"
+#include "screen.h"
+#include <algorithm>
+#include <utility>
+
+// --- Constants ---
+namespace constants
+{
+    // Frames measured on a rung before stepping down from it (one frame alone may be a spike)
+    const size_t QUALITY_MIN_SAMPLES = 2;
+    // Stepping down aims for frames at this share of the budget, leaving room for busier scenes
+    const double QUALITY_TARGET_USAGE = 0.9;
+    // Stepping up needs the better rung to be predicted at no more than this share of the budget
+    const double QUALITY_UP_USAGE = 0.75;
+    // Frames within budget before the first step up; doubled each time a step up has to be undone
+    const size_t QUALITY_UP_HOLD_FRAMES = 15;
+    const size_t QUALITY_MAX_UP_HOLD_FRAMES = 240;
+    // Channel rounding of the coarse color rung
+    const int QUALITY_COARSE_COLOR_STEP = 16;
+}
+// --- End Constants ---
+
+QualityLadder::QualityLadder(std::vector<QualityRung> rungs)
+    : ladder(std::move(rungs)), up_hold(constants::QUALITY_UP_HOLD_FRAMES)
+{
+    if (ladder.empty())
+    {
+        ladder.push_back(QualityRung{"full quality", QualitySettings(), 1.0});
+    }
+}
+
+// Smooth the usage of the current rung and move when it is over budget or comfortably under it.
+// The rungs' relative costs turn the measured usage into a prediction for every other rung.
+bool QualityLadder::record(size_t rung, double usage)
+{
+    if (rung != current)
+    {
+        return false; // Made before the last change; says nothing about the current rung
+    }
+    samples++;
+    smoothed = samples == 1 ? usage : smoothed + (usage - smoothed) / 2;
+
+    auto predicted = [this](size_t to) { return smoothed * ladder[to].relative_cost / ladder[current].relative_cost; };
+
+    size_t target = current;
+    if (smoothed > 1.0 && samples >= constants::QUALITY_MIN_SAMPLES && current + 1 < ladder.size())
+    {
+        // Step down to the best rung expected to fit (the last one if none is)
+        target = current + 1;
+        while (target + 1 < ladder.size() && predicted(target) > constants::QUALITY_TARGET_USAGE)
+        {
+            target++;
+        }
+        if (stepped_up)
+        {
+            // The rung above didn't fit after all: wait longer before trying it again
+            up_hold = std::min(up_hold * 2, constants::QUALITY_MAX_UP_HOLD_FRAMES);
+        }
+        stepped_up = false;
+    }
+    else if (current > 0 && samples >= up_hold && predicted(current - 1) <= constants::QUALITY_UP_USAGE)
+    {
+        target = current - 1;
+        stepped_up = true;
+    }
+    else
+    {
+        if (stepped_up && samples >= constants::QUALITY_UP_HOLD_FRAMES)
+        {
+            // The last step up held
+            up_hold = std::max(up_hold / 2, constants::QUALITY_UP_HOLD_FRAMES);
+            stepped_up = false;
+        }
+        return false;
+    }
+
+    current = target;
+    samples = 0;
+    smoothed = 0.0;
+    step_count++;
+    return true;
+}
+
+// Each rung keeps the savings of the rungs above it and adds one more
+std::vector<QualityRung> bandwidthLadder(const AsciiArtParams &params)
+{
+    std::vector<QualityRung> rungs;
+    QualitySettings settings;
+    double cost = 1.0;
+    auto add = [&](const char *name, double factor) {
+        cost *= factor;
+        rungs.push_back(QualityRung{name, settings, cost});
+    };
+    add("full quality", 1.0);
+
+    // Color escapes are most of the bytes of a color frame
+    if (params.color)
+    {
+        settings.color_step = constants::QUALITY_COARSE_COLOR_STEP;
+        add("coarse colors", 0.75);
+        settings.color_depth = ColorDepth::Palette256;
+        add("256 colors", 0.65);
+        settings.color_depth = ColorDepth::None;
+        add("no color", 0.3);
+    }
+
+    // Then fewer cells, then fewer updates per cell
+    settings.grid_percent = 75;
+    add("75% grid", 0.56);
+    settings.grid_percent = 50;
+    add("50% grid", 0.45);
+    settings.interlace = true;
+    add("50% grid, interlaced", 0.5);
+    return rungs;
+}
+
+// Each rung keeps the savings of the rungs above it and adds one more
+std::vector<QualityRung> renderLadder(const AsciiArtParams &params)
+{
+    std::vector<QualityRung> rungs;
+    QualitySettings settings;
+    double cost = 1.0;
+    auto add = [&](const char *name, double factor) {
+        cost *= factor;
+        rungs.push_back(QualityRung{name, settings, cost});
+    };
+    add("full quality", 1.0);
+
+    if (params.detect_edges)
+    {
+        settings.edges = false;
+        add("no edge pass", 0.6);
+    }
+    settings.fast_resize = true;
+    add("fast resize", 0.3);
+    if (params.color)
+    {
+        settings.color_depth = ColorDepth::None;
+        add("no color", 0.8);
+    }
+    settings.grid_percent = 75;
+    add("75% grid", 0.56);
+    settings.grid_percent = 50;
+    add("50% grid", 0.45);
+    return rungs;
+}
+
+// Field by field, the setting that takes more away
+QualitySettings combineQuality(const QualitySettings &a, const QualitySettings &b)
+{
+    QualitySettings combined;
+    combined.color_depth = std::max(a.color_depth, b.color_depth); // Declared from full to none
+    combined.color_step = std::max(a.color_step, b.color_step);
+    combined.grid_percent = std::min(a.grid_percent, b.grid_percent);
+    combined.interlace = a.interlace || b.interlace;
+    combined.edges = a.edges && b.edges;
+    combined.fast_resize = a.fast_resize || b.fast_resize;
+    return combined;
+}
+
+// Keep the lowest rung per second
+void QualityLadder::logShown(double seconds, size_t rung)
+{
+    size_t second = seconds > 0 ? static_cast<size_t>(seconds) : 0;
+    if (second >= seconds_log.size())
+    {
+        // Seconds without a shown frame take the rung of the second before
+        seconds_log.resize(second + 1, seconds_log.empty() ? rung : seconds_log.back());
+        seconds_log[second] = rung;
+    }
+    seconds_log[second] = std::max(seconds_log[second], rung);
+}
+
+// One entry per run of seconds on the same rung
+void QualityLadder::printLog(std::ostream &out, const char *label) const
+{
+    if (seconds_log.empty())
+    {
+        return;
+    }
+    out << "Quality per second (" << label << "):";
+    for (size_t start = 0; start < seconds_log.size();)
+    {
+        size_t end = start;
+        while (end + 1 < seconds_log.size() && seconds_log[end + 1] == seconds_log[start])
+        {
+            end++;
+        }
+        out << (start == 0 ? " " : ", ") << start;
+        if (end > start)
+        {
+            out << "-" << end;
+        }
+        out << "s " << ladder[seconds_log[start]].name;
+        start = end + 1;
+    }
+    out << std::endl;
+}
+
+// Round and snap colored cells in place
+void reduceGridColors(CellGrid &grid, const QualitySettings &settings)
+{
+    const bool palette = settings.color_depth == ColorDepth::Palette256;
+    if (!grid.color || (settings.color_step <= 1 && !palette))
+    {
+        return;
+    }
+    const int step = std::max(settings.color_step, 1);
+    auto quantize = [step](uint8_t v) { return static_cast<uint8_t>(std::min((v + step / 2) / step * step, 255)); };
+
+    for (Cell &cell : grid.cells)
+    {
+        if (!cell.colored)
+        {
+            continue;
+        }
+        if (step > 1)
+        {
+            cell.r = quantize(cell.r);
+            cell.g = quantize(cell.g);
+            cell.b = quantize(cell.b);
+        }
+        if (palette)
+        {
+            paletteColor(paletteIndex(cell.r, cell.g, cell.b), cell.r, cell.g, cell.b);
+            cell.indexed = true;
+        }
+    }
+}
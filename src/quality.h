@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ascii_art.h"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Color output of a quality rung, from full to none
+enum class ColorDepth
+{
+    TrueColor,  // 24-bit colors, as rendered
+    Palette256, // Colors snapped to the 256-color palette (shorter escapes, fewer distinct colors)
+    None        // No color escapes at all
+};
+
+// How video frames are rendered and sent on one rung of a quality ladder.
+// The defaults are full quality; every field only ever takes away from what the user asked for.
+struct QualitySettings
+{
+    ColorDepth color_depth = ColorDepth::TrueColor;
+    int color_step = 1;       // Color channels are rounded to multiples of this (fewer color changes between cells and frames)
+    int grid_percent = 100;   // Output grid columns and rows as a percentage of the full size
+    bool interlace = false;   // Each frame only updates every other row, alternating between even and odd rows
+    bool edges = true;        // Run the edge pass when the user asked for edges (off picks glyphs by brightness)
+    bool fast_resize = false; // Filter only every few source rows when downscaling (far less work, a little aliasing)
+};
+
+// One rung of a quality ladder
+struct QualityRung
+{
+    std::string name;         // Shown in statistics, e.g. "256 colors"
+    QualitySettings settings;
+    double relative_cost = 1.0; // Rough cost of a frame on this rung relative to rung 0, used to guess how far to step
+};
+
+// Ordered quality rungs (rung 0 is full quality) and a feedback controller that picks one so that
+// frames stay within a budget. The caller measures each frame against the budget and records the result
+// (1.0 = exactly on budget) with the rung the frame was made on; frames made on an earlier rung are ignored.
+// Over budget, the controller steps down as far as the rungs' relative costs say is needed, so it settles
+// within a few frames. It steps back up one rung at a time, only after a run of frames well within budget
+// on the current rung, and waits longer before the next try each time a step up had to be undone.
+// Not thread-safe: one thread records and steps; publish rung() to others.
+class QualityLadder
+{
+public:
+    // rungs: At least one rung, from full quality down
+    explicit QualityLadder(std::vector<QualityRung> rungs);
+
+    // Record one frame's use of the budget
+    // rung: The rung the frame was made on
+    // usage: Measured cost divided by the budget
+    // Returns: true if the controller moved to another rung
+    bool record(size_t rung, double usage);
+
+    // The rung frames should be made on now
+    size_t rung() const { return current; }
+
+    const std::vector<QualityRung> &rungs() const { return ladder; }
+
+    // Number of times the controller has changed rungs
+    size_t steps() const { return step_count; }
+
+    // Remember the rung a frame was shown on, for the per-second log
+    // seconds: Time since playback started
+    // rung: The rung the frame was made on
+    void logShown(double seconds, size_t rung);
+
+    // Print which rung was in use for each second of playback (the lowest one shown during that second),
+    // with runs of seconds on the same rung merged: "0-4s full quality, 5s no color, ..."
+    // out: Where to print
+    // label: What the ladder budgets, e.g. "render time"
+    void printLog(std::ostream &out, const char *label) const;
+
+private:
+    std::vector<QualityRung> ladder;
+    size_t current = 0;
+    double smoothed = 0.0;      // Smoothed usage of frames on the current rung
+    size_t samples = 0;         // Frames measured on the current rung
+    size_t up_hold;             // Frames within budget needed before stepping up
+    bool stepped_up = false;    // The last change was a step up (undone if it goes over budget right away)
+    size_t step_count = 0;
+    std::vector<size_t> seconds_log; // Lowest rung shown in each second of playback
+};
+
+// --- Function Declarations ---
+
+// Rungs for a byte budget: coarser and then palette colors, then no color, then smaller grids, then interlacing.
+// Color rungs are left out for monochrome output.
+// params: The user's rendering parameters
+std::vector<QualityRung> bandwidthLadder(const AsciiArtParams &params);
+
+// Rungs for a render time budget: no edge pass, a resize that skips source rows, no color, then smaller grids.
+// Rungs that would change nothing for these parameters (edges or color not asked for) are left out.
+// params: The user's rendering parameters
+std::vector<QualityRung> renderLadder(const AsciiArtParams &params);
+
+// Settings that satisfy two ladders at once: whichever of the two takes more away, field by field
+QualitySettings combineQuality(const QualitySettings &a, const QualitySettings &b);
+
+// Apply a rung's color settings to a rendered grid
+// grid: Rendered cells; colored cells are rounded to the rung's color step and, for the palette, snapped to it
+// settings: The rung's settings
+void reduceGridColors(CellGrid &grid, const QualitySettings &settings);
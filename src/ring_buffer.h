@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Bounded single-producer/single-consumer ring buffer with preallocated slots.
+// Slots are filled and drained in place (acquire a slot, use it, commit it), so whatever a slot owns
+// (frame buffers, strings) keeps its allocation from one use to the next and nothing is copied in or out.
+// Lock-free: the producer only writes 'tail', the consumer only writes 'head'.
+template <typename T>
+class SpscRing
+{
+public:
+    // capacity: Number of slots (at least 1)
+    explicit SpscRing(size_t capacity) : slots(capacity > 0 ? capacity : 1) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer: the next free slot, or nullptr if the ring is full.
+    // The slot still holds whatever it held when it was last consumed.
+    T *tryAcquireWrite()
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size())
+        {
+            return nullptr;
+        }
+        return &slots[t % slots.size()];
+    }
+
+    // Producer: publish the slot returned by tryAcquireWrite
+    void commitWrite()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: the oldest published slot, or nullptr if the ring is empty
+    T *tryAcquireRead()
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &slots[h % slots.size()];
+    }
+
+    // Consumer: the published slot 'ahead' places after the oldest one (0 is what tryAcquireRead returns),
+    // or nullptr if fewer slots are published. Nothing is consumed.
+    T *peek(size_t ahead)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (tail.load(std::memory_order_acquire) - h <= ahead)
+        {
+            return nullptr;
+        }
+        return &slots[(h + ahead) % slots.size()];
+    }
+
+    // Consumer: hand the slot returned by tryAcquireRead back to the producer
+    void commitRead()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Producer: no more slots will be published
+    void close() { closed.store(true, std::memory_order_release); }
+
+    // Consumer: true once the producer has closed the ring (published slots may still be waiting)
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    // Number of published slots not yet consumed (a snapshot when called from a third thread)
+    size_t depth() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+
+    size_t capacity() const { return slots.size(); }
+
+private:
+    std::vector<T> slots;
+    // Producer and consumer indices on separate cache lines so the two threads don't contend
+    alignas(64) std::atomic<size_t> head{0}; // Next slot to consume
+    alignas(64) std::atomic<size_t> tail{0}; // Next slot to fill
+    alignas(64) std::atomic<bool> closed{false};
+};
+
+// Back-off for threads waiting on a ring: yield a few times first, then sleep briefly so a waiting
+// thread doesn't keep a core busy while the other side is slow.
+// attempt: How many times the caller has waited so far (reset it after making progress).
+inline void ringBackoff(unsigned int &attempt)
+{
+    if (attempt++ < 64)
+    {
+        std::this_thread::yield();
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
@@ -0,0 +1,679 @@
+#include "screen.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#include <stdio.h>
+#else
+#include <unistd.h>
+#endif
+
+// --- Constants ---
+namespace constants
+{
+    const char SGR_RESET[] = "\033[0m"; // Back to the default foreground
+    const size_t SGR_RESET_SIZE = 4;
+    const char SGR_TRUECOLOR_PREFIX[] = "\033[38;2;"; // Followed by R;G;Bm
+    const size_t SGR_TRUECOLOR_PREFIX_SIZE = 7;
+    const char SGR_PALETTE_PREFIX[] = "\033[38;5;"; // Followed by the palette index and m
+    const size_t SGR_PALETTE_PREFIX_SIZE = 7;
+    // Channel levels of the 6x6x6 color cube (palette entries 16-231)
+    const uint8_t PALETTE_CUBE_LEVELS[6] = {0, 95, 135, 175, 215, 255};
+    // First gray ramp entry (232-255 run from 8 to 238 in steps of 10)
+    const int PALETTE_GRAY_BASE = 232;
+}
+// --- End Constants ---
+
+// Number of decimal digits of a non-negative value
+static size_t decimalDigits(int value)
+{
+    size_t digits = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+// Append a non-negative value in decimal without going through std::to_string
+static void appendDecimal(std::string &out, int value)
+{
+    char digits[12];
+    int count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0)
+    {
+        out += digits[--count];
+    }
+}
+
+// --- 256-Color Palette ---
+
+// Nearest entry of the xterm 256-color palette: the 6x6x6 cube or the gray ramp, whichever is closer.
+// The 16 system colors are left out because terminals theme them.
+int paletteIndex(uint8_t r, uint8_t g, uint8_t b)
+{
+    auto cubeLevel = [](int v) { return v < 48 ? 0 : v < 115 ? 1 : (v - 35) / 40; };
+    const int cr = cubeLevel(r), cg = cubeLevel(g), cb = cubeLevel(b);
+    auto distance = [r, g, b](int pr, int pg, int pb) {
+        return (pr - r) * (pr - r) + (pg - g) * (pg - g) + (pb - b) * (pb - b);
+    };
+    const int cube_distance = distance(constants::PALETTE_CUBE_LEVELS[cr], constants::PALETTE_CUBE_LEVELS[cg],
+                                       constants::PALETTE_CUBE_LEVELS[cb]);
+
+    const int average = (r + g + b) / 3;
+    const int gray = average > 238 ? 23 : average < 8 ? 0 : (average - 3) / 10;
+    const int level = 8 + 10 * gray;
+    if (distance(level, level, level) < cube_distance)
+    {
+        return constants::PALETTE_GRAY_BASE + gray;
+    }
+    return 16 + 36 * cr + 6 * cg + cb;
+}
+
+// Color of a palette entry (16-255)
+void paletteColor(int index, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    if (index >= constants::PALETTE_GRAY_BASE)
+    {
+        r = g = b = static_cast<uint8_t>(8 + 10 * (index - constants::PALETTE_GRAY_BASE));
+        return;
+    }
+    index -= 16;
+    r = constants::PALETTE_CUBE_LEVELS[index / 36];
+    g = constants::PALETTE_CUBE_LEVELS[index / 6 % 6];
+    b = constants::PALETTE_CUBE_LEVELS[index % 6];
+}
+
+// Append the foreground escape for a cell's color: a palette index for indexed cells, 24-bit otherwise
+static void appendColor(std::string &out, const Cell &cell)
+{
+    if (cell.indexed)
+    {
+        out.append(constants::SGR_PALETTE_PREFIX, constants::SGR_PALETTE_PREFIX_SIZE);
+        appendDecimal(out, paletteIndex(cell.r, cell.g, cell.b));
+        out += 'm';
+        return;
+    }
+    out.append(constants::SGR_TRUECOLOR_PREFIX, constants::SGR_TRUECOLOR_PREFIX_SIZE);
+    appendDecimal(out, cell.r);
+    out += ';';
+    appendDecimal(out, cell.g);
+    out += ';';
+    appendDecimal(out, cell.b);
+    out += 'm';
+}
+
+// Size of the foreground escape for a cell's color
+static size_t colorSize(const Cell &cell)
+{
+    if (cell.indexed)
+    {
+        return constants::SGR_PALETTE_PREFIX_SIZE + decimalDigits(paletteIndex(cell.r, cell.g, cell.b)) + 1;
+    }
+    return constants::SGR_TRUECOLOR_PREFIX_SIZE + decimalDigits(cell.r) + decimalDigits(cell.g) + decimalDigits(cell.b) + 3;
+}
+
+// Write the grid as text, escape for escape the way the renderer always has
+void appendGridText(const CellGrid &grid, std::string &out)
+{
+    for (int y = 0; y < grid.height; y++)
+    {
+        const Cell *row = grid.row(y);
+        for (int x = 0; x < grid.width; x++)
+        {
+            if (row[x].colored)
+            {
+                appendColor(out, row[x]);
+            }
+            out += row[x].glyph;
+        }
+
+        // Reset color at the end of each line to prevent bleeding into the next line or prompt
+        if (grid.color)
+        {
+            out.append(constants::SGR_RESET, constants::SGR_RESET_SIZE);
+        }
+        out += '\n';
+    }
+}
+
+// True if standard output is a terminal
+bool stdoutIsTerminal()
+{
+#ifdef _WIN32
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return isatty(STDOUT_FILENO) != 0;
+#endif
+}
+
+// --- Delta Encoding ---
+
+// Bytes needed to draw a cell given the terminal's current foreground ('pen'), which is updated.
+// Blanks are drawn in whatever color is current; a colored cell only needs an escape if the color differs.
+static size_t cellCost(const Cell &cell, Cell &pen)
+{
+    if (cell.glyph == ' ')
+    {
+        return 1;
+    }
+    if (cell.colored)
+    {
+        if (pen.colored && pen.r == cell.r && pen.g == cell.g && pen.b == cell.b)
+        {
+            return 1;
+        }
+        pen = cell;
+        return 1 + colorSize(cell);
+    }
+    if (pen.colored)
+    {
+        pen.colored = false;
+        return 1 + constants::SGR_RESET_SIZE;
+    }
+    return 1;
+}
+
+// Draw a cell, emitting a color escape only when cellCost would count one
+static void appendCell(const Cell &cell, Cell &pen, std::string &out)
+{
+    if (cell.glyph != ' ')
+    {
+        if (cell.colored)
+        {
+            if (!pen.colored || pen.r != cell.r || pen.g != cell.g || pen.b != cell.b)
+            {
+                appendColor(out, cell);
+                pen = cell;
+            }
+        }
+        else if (pen.colored)
+        {
+            out.append(constants::SGR_RESET, constants::SGR_RESET_SIZE);
+            pen.colored = false;
+        }
+    }
+    out += cell.glyph;
+}
+
+// Move the cursor to (x, y) from somewhere on row cursor_y, or from an unknown position if cursor_y < 0.
+// Picks the shortest of an absolute move (CSI row;col H) and newlines followed by a forward move.
+static void appendCursorMove(int x, int y, int cursor_y, std::string &out)
+{
+    // Absolute: ESC [ row ; col H, with the column left out for the first column
+    size_t absolute = 3 + decimalDigits(y + 1) + (x > 0 ? 1 + decimalDigits(x + 1) : 0);
+    if (cursor_y >= 0 && cursor_y < y)
+    {
+        // Newlines return to the first column (the tty translates them to CR LF), then ESC [ n C
+        size_t relative = static_cast<size_t>(y - cursor_y) + (x > 0 ? 3 + decimalDigits(x) : 0);
+        if (relative < absolute)
+        {
+            out.append(static_cast<size_t>(y - cursor_y), '\n');
+            if (x > 0)
+            {
+                out += "\033[";
+                appendDecimal(out, x);
+                out += 'C';
+            }
+            return;
+        }
+    }
+    out += "\033[";
+    appendDecimal(out, y + 1);
+    if (x > 0)
+    {
+        out += ';';
+        appendDecimal(out, x + 1);
+    }
+    out += 'H';
+}
+
+// Write each row up to its last visible cell, skipping blank runs with the cursor where that saves bytes
+void appendGridSparse(const CellGrid &grid, std::string &out)
+{
+    for (int y = 0; y < grid.height; y++)
+    {
+        const Cell *row = grid.row(y);
+
+        // Trailing blanks are left out entirely
+        int end = grid.width;
+        while (end > 0 && row[end - 1].glyph == ' ')
+        {
+            end--;
+        }
+
+        Cell pen; // Every row starts and ends with the default color
+        for (int x = 0; x < end;)
+        {
+            if (row[x].glyph != ' ')
+            {
+                appendCell(row[x], pen, out);
+                x++;
+                continue;
+            }
+
+            // A blank run always ends before 'end', which is visible
+            int run_end = x;
+            while (row[run_end].glyph == ' ')
+            {
+                run_end++;
+            }
+            int length = run_end - x;
+            if (3 + decimalDigits(length) < static_cast<size_t>(length))
+            {
+                out += "\033[";
+                appendDecimal(out, length);
+                out += 'C';
+            }
+            else
+            {
+                out.append(static_cast<size_t>(length), ' ');
+            }
+            x = run_end;
+        }
+
+        // Reset color at the end of each line to prevent bleeding into the next line or prompt
+        if (pen.colored)
+        {
+            out.append(constants::SGR_RESET, constants::SGR_RESET_SIZE);
+        }
+        out += '\n';
+    }
+}
+
+// Parse the renderer's text format: cells, each optionally preceded by a 24-bit color escape, and row resets
+void parseGridText(const std::string &text, CellGrid &grid)
+{
+    grid.width = 0;
+    grid.height = 0;
+    grid.color = false;
+    grid.cells.clear();
+
+    std::vector<std::vector<Cell>> rows(1);
+    Cell pen;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        const char c = text[i];
+        if (c == '\n')
+        {
+            rows.emplace_back();
+            continue;
+        }
+        if (c == '\033' && i + 1 < text.size() && text[i + 1] == '[')
+        {
+            // Read up to the final byte; only the foreground escapes the renderer writes are interpreted
+            size_t end = i + 2;
+            while (end < text.size() && !(text[end] >= 0x40 && text[end] <= 0x7E))
+            {
+                end++;
+            }
+            if (end < text.size() && text[end] == 'm')
+            {
+                int r = 0, g = 0, b = 0;
+                if (std::sscanf(text.c_str() + i + 2, "38;2;%d;%d;%dm", &r, &g, &b) == 3)
+                {
+                    pen.colored = true;
+                    pen.r = static_cast<uint8_t>(r);
+                    pen.g = static_cast<uint8_t>(g);
+                    pen.b = static_cast<uint8_t>(b);
+                }
+                else
+                {
+                    pen = Cell();
+                    grid.color = true;
+                }
+            }
+            i = end;
+            continue;
+        }
+        Cell cell = pen;
+        cell.glyph = c;
+        rows.back().push_back(cell);
+    }
+    if (rows.back().empty())
+    {
+        rows.pop_back(); // Text ends with a newline
+    }
+
+    for (const auto &row : rows)
+    {
+        grid.width = std::max(grid.width, static_cast<int>(row.size()));
+    }
+    grid.height = static_cast<int>(rows.size());
+    grid.cells.resize(static_cast<size_t>(grid.width) * static_cast<size_t>(grid.height));
+    for (int y = 0; y < grid.height; y++)
+    {
+        std::copy(rows[y].begin(), rows[y].end(), grid.row(y));
+    }
+}
+
+// Send only what changed between two frames of the same size
+void appendGridDelta(const CellGrid &previous, const CellGrid &next, std::string &out)
+{
+    Cell pen;          // Terminal foreground; every frame ends with colors reset
+    int cursor_x = 0;  // Where the next character would be drawn
+    int cursor_y = -1; // Unknown until the first change
+
+    for (int y = 0; y < next.height; y++)
+    {
+        const Cell *was = previous.row(y);
+        const Cell *now = next.row(y);
+        for (int x = 0; x < next.width; x++)
+        {
+            if (now[x].looksLike(was[x]))
+            {
+                continue;
+            }
+
+            if (cursor_y == y && cursor_x < x)
+            {
+                // Same row: rewrite the unchanged gap if that is no longer than skipping over it
+                const size_t skip = 3 + decimalDigits(x - cursor_x);
+                size_t rewrite = 0;
+                Cell simulated = pen;
+                for (int i = cursor_x; i < x && rewrite <= skip; i++)
+                {
+                    rewrite += cellCost(now[i], simulated);
+                }
+                if (rewrite <= skip)
+                {
+                    for (int i = cursor_x; i < x; i++)
+                    {
+                        appendCell(now[i], pen, out);
+                    }
+                }
+                else
+                {
+                    out += "\033[";
+                    appendDecimal(out, x - cursor_x);
+                    out += 'C';
+                }
+            }
+            else if (cursor_y != y || cursor_x != x)
+            {
+                appendCursorMove(x, y, cursor_y, out);
+            }
+
+            appendCell(now[x], pen, out);
+            cursor_x = x + 1;
+            cursor_y = y;
+        }
+    }
+
+    // Leave the terminal with its default colors, as full frames do
+    if (pen.colored)
+    {
+        out.append(constants::SGR_RESET, constants::SGR_RESET_SIZE);
+    }
+}
+
+// --- Virtual Screen ---
+
+VirtualScreen::VirtualScreen(int width, int height)
+    : width(std::max(width, 1)), height(std::max(height, 1)),
+      cells(static_cast<size_t>(this->width) * static_cast<size_t>(this->height))
+{
+}
+
+// Keep the content in place while adding columns and rows
+void VirtualScreen::ensureSize(int new_width, int new_height)
+{
+    if (new_width <= width && new_height <= height)
+    {
+        return;
+    }
+    new_width = std::max(new_width, width);
+    new_height = std::max(new_height, height);
+    std::vector<Cell> grown(static_cast<size_t>(new_width) * static_cast<size_t>(new_height));
+    for (int y = 0; y < height; y++)
+    {
+        std::copy(cells.begin() + static_cast<size_t>(y) * width, cells.begin() + static_cast<size_t>(y + 1) * width,
+                  grown.begin() + static_cast<size_t>(y) * new_width);
+    }
+    cells.swap(grown);
+    width = new_width;
+    height = new_height;
+}
+
+// Run the bytes through a small escape sequence parser
+void VirtualScreen::feed(const char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        const char c = data[i];
+        switch (state)
+        {
+        case ParseState::Text:
+            if (c == '\033')
+            {
+                state = ParseState::Escape;
+            }
+            else if (c == '\n')
+            {
+                cursor_x = 0;
+                cursor_y++;
+            }
+            else if (c == '\r')
+            {
+                cursor_x = 0;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                if (error.empty())
+                {
+                    error = "unexpected control character " + std::to_string(static_cast<int>(c));
+                }
+            }
+            else
+            {
+                put(c);
+            }
+            break;
+
+        case ParseState::Escape:
+            if (c == '[')
+            {
+                csi_params.clear();
+                state = ParseState::Csi;
+            }
+            else
+            {
+                if (error.empty())
+                {
+                    error = std::string("unsupported escape ESC ") + c;
+                }
+                state = ParseState::Text;
+            }
+            break;
+
+        case ParseState::Csi:
+            if (c >= 0x40 && c <= 0x7E)
+            {
+                applyCsi(c);
+                state = ParseState::Text;
+            }
+            else
+            {
+                csi_params += c; // Parameter and intermediate bytes
+            }
+            break;
+        }
+    }
+}
+
+// Write a character with the current pen and advance the cursor
+void VirtualScreen::put(char c)
+{
+    if (cursor_x < 0 || cursor_x >= width || cursor_y < 0 || cursor_y >= height)
+    {
+        if (error.empty())
+        {
+            error = "character written outside the screen at column " + std::to_string(cursor_x + 1) +
+                    ", row " + std::to_string(cursor_y + 1);
+        }
+    }
+    else
+    {
+        Cell &cell = cells[static_cast<size_t>(cursor_y) * width + cursor_x];
+        cell = pen;
+        cell.glyph = c;
+    }
+    cursor_x++;
+}
+
+// Interpret the sequences the encoders use
+void VirtualScreen::applyCsi(char final_byte)
+{
+    // Numeric parameters; empty ones are -1 so each sequence can apply its own default
+    std::vector<int> params;
+    bool numeric = true;
+    size_t start = 0;
+    while (start <= csi_params.size())
+    {
+        size_t end = csi_params.find(';', start);
+        if (end == std::string::npos)
+        {
+            end = csi_params.size();
+        }
+        int value = -1;
+        for (size_t i = start; i < end; i++)
+        {
+            char d = csi_params[i];
+            if (d < '0' || d > '9')
+            {
+                numeric = false;
+                break;
+            }
+            value = (value < 0 ? 0 : value * 10) + (d - '0');
+        }
+        params.push_back(value);
+        start = end + 1;
+    }
+    auto param = [&params](size_t i, int fallback) { return i < params.size() && params[i] >= 0 ? params[i] : fallback; };
+    auto clear = [this](int from_x, int to_x, int y) {
+        for (int x = std::max(from_x, 0); x < std::min(to_x, width); x++)
+        {
+            cells[static_cast<size_t>(y) * width + x] = Cell();
+        }
+    };
+
+    // Private mode changes (e.g. synchronized updates, ESC [ ? 2026 h) don't change what the screen shows
+    if (!csi_params.empty() && csi_params[0] == '?' && (final_byte == 'h' || final_byte == 'l'))
+    {
+        return;
+    }
+
+    if (numeric)
+    {
+        switch (final_byte)
+        {
+        case 'H': // Cursor position (1-based)
+            cursor_y = param(0, 1) - 1;
+            cursor_x = param(1, 1) - 1;
+            return;
+        case 'C': // Cursor forward
+            cursor_x += std::max(param(0, 1), 1);
+            return;
+        case 'K': // Erase in line
+            if (cursor_y >= 0 && cursor_y < height)
+            {
+                int mode = param(0, 0);
+                clear(mode == 0 ? cursor_x : 0, mode == 1 ? cursor_x + 1 : width, cursor_y);
+            }
+            return;
+        case 'J': // Erase in display
+            if (param(0, 0) == 2)
+            {
+                std::fill(cells.begin(), cells.end(), Cell());
+                return;
+            }
+            break;
+        case 'm': // Select graphic rendition: only the foreground color is tracked
+            for (size_t i = 0; i < params.size(); i++)
+            {
+                int p = param(i, 0);
+                if (p == 0)
+                {
+                    pen = Cell();
+                }
+                else if (p == 39)
+                {
+                    pen.colored = false;
+                }
+                else if (p == 38 && param(i + 1, 0) == 5 && i + 2 < params.size() && param(i + 2, 0) >= 16 &&
+                         param(i + 2, 0) <= 255)
+                {
+                    pen.colored = true;
+                    pen.indexed = true;
+                    paletteColor(param(i + 2, 0), pen.r, pen.g, pen.b);
+                    i += 2;
+                }
+                else if (p == 38 && param(i + 1, 0) == 2 && i + 4 < params.size())
+                {
+                    pen.colored = true;
+                    pen.indexed = false;
+                    pen.r = static_cast<uint8_t>(param(i + 2, 0));
+                    pen.g = static_cast<uint8_t>(param(i + 3, 0));
+                    pen.b = static_cast<uint8_t>(param(i + 4, 0));
+                    i += 4;
+                }
+                else
+                {
+                    break;
+                }
+            }
+            return;
+        default:
+            break;
+        }
+    }
+
+    if (error.empty())
+    {
+        error = "unsupported sequence ESC [" + csi_params + final_byte;
+    }
+}
+
+// Compare cell by cell; blanks match whatever their color
+bool VirtualScreen::matches(const CellGrid &grid, std::string &mismatch) const
+{
+    if (!error.empty())
+    {
+        mismatch = error;
+        return false;
+    }
+
+    const Cell blank;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const Cell &shown = cells[static_cast<size_t>(y) * width + x];
+            const Cell &expected = (x < grid.width && y < grid.height) ? grid.row(y)[x] : blank;
+            if (!shown.looksLike(expected))
+            {
+                auto describe = [](const Cell &cell) {
+                    std::string text = std::string("'") + cell.glyph + "'";
+                    if (cell.colored)
+                    {
+                        text += " rgb(" + std::to_string(cell.r) + "," + std::to_string(cell.g) + "," +
+                                std::to_string(cell.b) + ")";
+                    }
+                    return text;
+                };
+                mismatch = "column " + std::to_string(x + 1) + ", row " + std::to_string(y + 1) + ": expected " +
+                           describe(expected) + ", screen shows " + describe(shown);
+                return false;
+            }
+        }
+    }
+    return true;
+}
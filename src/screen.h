@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ascii_art.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Terminal setup for video playback: full reset, alternate screen, cleared screen with the cursor home and
+// hidden, mouse events captured
+inline const std::string PLAYBACK_SCREEN_SETUP = "\033c\033[?1049h\033[2J\033[1;1H\033[?25l\033[?1000h";
+// Undoes it: mouse capture off, cursor shown, alternate screen left
+inline const std::string PLAYBACK_SCREEN_RESTORE = "\033[?1000l\033[?25h\033[?1049l";
+// Begin and end of a synchronized update (DEC private mode 2026): the terminal holds its repaint until the end
+inline const char SYNC_UPDATE_BEGIN[] = "\033[?2026h";
+inline const char SYNC_UPDATE_END[] = "\033[?2026l";
+
+// --- Function Declarations ---
+
+// Append a cell grid as plain text: one line per row, a 24-bit color escape before every colored cell
+// and a color reset at the end of every row of a color grid. This is the format generateAsciiText produces.
+// grid: The cells to write
+// out: Receives the text (appended)
+void appendGridText(const CellGrid &grid, std::string &out);
+
+// Append a cell grid for a terminal whose rows start out blank (fresh lines below the prompt, or a cleared screen).
+// Shows the same as appendGridText with fewer bytes: runs of blanks become cursor-forward moves (CSI n C) where
+// that is shorter, trailing blanks are dropped, and a color escape is only sent when the color changes.
+// Rows still end with a newline, and color rows with a reset.
+// grid: The cells to write
+// out: Receives the encoded rows (appended)
+void appendGridSparse(const CellGrid &grid, std::string &out);
+
+// Read text in the format appendGridText writes back into a cell grid (e.g. output cache entries)
+// text: Rendered ASCII art
+// grid: Receives the cells; rows shorter than the longest one are padded with blanks
+void parseGridText(const std::string &text, CellGrid &grid);
+
+// Nearest entry of the xterm 256-color palette (the color cube and gray ramp, 16-255) to a 24-bit color
+int paletteIndex(uint8_t r, uint8_t g, uint8_t b);
+
+// Color of a palette entry
+// index: 16-255, as returned by paletteIndex
+// r, g, b: Receive the entry's 24-bit color
+void paletteColor(int index, uint8_t &r, uint8_t &g, uint8_t &b);
+
+// True if standard output is a terminal (rather than a file or a pipe)
+bool stdoutIsTerminal();
+
+// Append the bytes that turn a terminal showing 'previous' into one showing 'next'.
+// Only cells that look different are written. Between two changed runs on a row, the encoder either moves
+// the cursor forward or rewrites the unchanged cells in between, whichever takes fewer bytes; rows are
+// reached with a newline or an absolute cursor move, again whichever is shorter.
+// The frame is drawn from the terminal's top-left corner and the cursor is left wherever the last change was.
+// previous: The grid currently on the terminal (same dimensions as 'next')
+// next: The grid to show
+// out: Receives the escape sequences and cells (appended); nothing is appended if no cell changed
+void appendGridDelta(const CellGrid &previous, const CellGrid &next, std::string &out);
+
+// Terminal model used to check the output encoders: replays the bytes sent to the terminal into a grid of cells.
+// Understands what the encoders emit: printable characters, '\n' (as a newline with carriage return, like a
+// tty with ONLCR), '\r', and the CSI sequences H (cursor position), C (cursor forward), K (erase in line),
+// J (erase in display), m (reset, 24-bit, 256-color and default foreground) and private mode switches (ignored).
+// Anything else is reported as an error.
+class VirtualScreen
+{
+public:
+    // width, height: Initial screen size in cells (the screen grows when a frame needs more room)
+    VirtualScreen(int width, int height);
+
+    // Replay terminal output; escape sequences may be split across calls
+    void feed(const char *data, size_t size);
+    void feed(const std::string &bytes) { feed(bytes.data(), bytes.size()); }
+
+    // Grow the screen to at least width x height cells, keeping its content
+    void ensureSize(int width, int height);
+
+    // Check that the screen shows 'grid' in its top-left corner and nothing else
+    // grid: The expected frame
+    // mismatch: Receives a description of the first difference (or of a replay error)
+    // Returns: true if the screen matches and the replayed bytes contained nothing unsupported
+    bool matches(const CellGrid &grid, std::string &mismatch) const;
+
+private:
+    // Apply one complete CSI sequence
+    void applyCsi(char final_byte);
+    // Write one printable character at the cursor
+    void put(char c);
+
+    int width;
+    int height;
+    std::vector<Cell> cells;
+    int cursor_x = 0;
+    int cursor_y = 0;
+    Cell pen;          // Color applied to written characters
+    std::string error; // First replay error, if any
+
+    // Escape sequence parser state
+    enum class ParseState
+    {
+        Text,
+        Escape, // After ESC
+        Csi     // After ESC [
+    };
+    ParseState state = ParseState::Text;
+    std::string csi_params; // Parameter bytes of the CSI sequence being parsed
+};
@@ -0,0 +1,84 @@
+#include "text_export.h"
+#include "output.h"
+#include "screen.h"
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+// --- Constants ---
+namespace constants
+{
+    // Frames are written to a framed text file in chunks of about this size
+    const size_t TEXT_EXPORT_FLUSH_BYTES = 1 << 20;
+    // Line between two frames of a framed text file
+    const char TEXT_EXPORT_FRAME_SEPARATOR[] = "\f\n";
+}
+// --- End Constants ---
+
+// --- Framed File ---
+
+// Opened in text mode like saveOutputText, so line endings match image output and per-frame files (CRLF on Windows)
+FramedTextWriter::FramedTextWriter(const std::string &path) : path(path), file(path, std::ios::out | std::ios::trunc)
+{
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open output file for writing: " + path);
+    }
+    buffer.reserve(constants::TEXT_EXPORT_FLUSH_BYTES * 2);
+}
+
+void FramedTextWriter::addFrame(const CellGrid &frame, std::chrono::nanoseconds)
+{
+    if (frames > 0)
+    {
+        buffer += constants::TEXT_EXPORT_FRAME_SEPARATOR;
+    }
+    appendGridText(frame, buffer);
+    frames++;
+    flush(constants::TEXT_EXPORT_FLUSH_BYTES);
+}
+
+void FramedTextWriter::finish(std::chrono::nanoseconds)
+{
+    flush(0);
+    file.close();
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write output file: " + path);
+    }
+}
+
+void FramedTextWriter::flush(size_t threshold)
+{
+    if (buffer.empty() || buffer.size() < threshold)
+    {
+        return;
+    }
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write output file: " + path);
+    }
+    buffer.clear();
+}
+
+// --- One File per Frame ---
+
+TextFrameFilesWriter::TextFrameFilesWriter(const std::string &dir, const std::string &name) : dir(dir), name(name)
+{
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error)
+    {
+        throw std::runtime_error("Failed to create output directory: " + dir + " - " + error.message());
+    }
+}
+
+void TextFrameFilesWriter::addFrame(const CellGrid &frame, std::chrono::nanoseconds)
+{
+    char number[16];
+    std::snprintf(number, sizeof(number), "_%06zu.txt", ++frames);
+    text.clear();
+    appendGridText(frame, text);
+    saveOutputText(text, (std::filesystem::path(dir) / (name + number)).string());
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ascii_art.h"
+#include <chrono>
+#include <fstream>
+#include <string>
+
+// Writes video frames as plain text (the format of image output files) into one file, with a line holding
+// only a form feed between frames. Frames are gathered in a buffer and written in large chunks.
+class FramedTextWriter : public FrameSink
+{
+public:
+    // path: Output file (replaced if it exists)
+    // Throws: std::runtime_error if the file can't be created
+    explicit FramedTextWriter(const std::string &path);
+
+    void addFrame(const CellGrid &frame, std::chrono::nanoseconds pts) override;
+
+    // Write what is left in the buffer and close the file
+    void finish(std::chrono::nanoseconds duration) override;
+
+private:
+    // Write the buffer to the file once it holds this much or more (all of it when 'threshold' is 0)
+    void flush(size_t threshold);
+
+    std::string path;
+    std::ofstream file;
+    std::string buffer; // Frames waiting to be written
+    size_t frames = 0;
+};
+
+// Writes each video frame as plain text to its own file: <dir>/<name>_000001.txt, <name>_000002.txt, ...
+// Each file is written with a single write of the whole frame.
+class TextFrameFilesWriter : public FrameSink
+{
+public:
+    // dir: Output directory (created if missing)
+    // name: File name prefix, e.g. the video's name without its extension
+    // Throws: std::runtime_error if the directory can't be created
+    TextFrameFilesWriter(const std::string &dir, const std::string &name);
+
+    void addFrame(const CellGrid &frame, std::chrono::nanoseconds pts) override;
+
+    void finish(std::chrono::nanoseconds) override {}
+
+private:
+    std::string dir;
+    std::string name;
+    std::string text; // The frame being written, reused
+    size_t frames = 0;
+};
@@ -0,0 +1,1492 @@
+#include "video.h"
+#include "ascii_art.h"
+#include "edge_detection.h"
+#include "image.h"
+#include "ring_buffer.h"
+#include "screen.h"
+#include "output.h"
+#include "quality.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --- Constants ---
+namespace constants
+{
+    // Decoded frames buffered per render worker; enough to ride out a slow decode without adding much latency
+    const size_t VIDEO_DECODE_SLOTS_PER_WORKER = 2;
+    // Rendered frames buffered per render worker while they wait for the output thread
+    const size_t VIDEO_RENDER_SLOTS_PER_WORKER = 2;
+    // Upper bound for the default number of render workers (more rarely helps at terminal resolutions)
+    const unsigned int VIDEO_MAX_DEFAULT_RENDER_WORKERS = 4;
+    // The same for exports, which have no output thread and no frame rate to keep up with, only throughput
+    const unsigned int VIDEO_MAX_DEFAULT_EXPORT_WORKERS = 16;
+    // Fewest frames per segment worth a capture of its own when an export is split into segments
+    const size_t VIDEO_MIN_SEGMENT_FRAMES = 30;
+    // A segment whose frame-number seek lands off its cut is seeked by time to this many frames before the cut,
+    // then read forward to it (doubled on each retry, up to VIDEO_SEEK_ATTEMPTS tries)
+    const size_t VIDEO_SEEK_BACKOFF_FRAMES = 30;
+    const int VIDEO_SEEK_ATTEMPTS = 4;
+    // Frame period used with the auto delay when the file reports no frame rate
+    const double VIDEO_FALLBACK_DELAY_MS = 100.0;
+    // Longest wait for the terminal to answer the synchronized-update query (local terminals answer in well under 10 ms)
+    const int VIDEO_SYNC_QUERY_TIMEOUT_MS = 200;
+    // A frame write that blocks for more than 1/N of the frame period means the terminal is backed up
+    const int VIDEO_OUTPUT_BLOCKED_FRACTION = 4;
+    // After such a write, frames due within 1/N of the time it blocked are skipped rather than queued behind it
+    const int VIDEO_OUTPUT_HOLD_FRACTION = 4;
+}
+// --- End Constants ---
+
+using Clock = std::chrono::steady_clock;
+
+// A decoded frame waiting for its render worker.
+// Slots are reused, so 'frame' keeps its buffer and the decoder writes each new frame into it in place.
+struct DecodedFrame
+{
+    cv::Mat frame;
+    Clock::duration pts{0};         // Presentation time relative to the first frame of the file
+    Clock::time_point decode_start; // Before the decoder was asked for the frame
+    Clock::time_point decoded;      // After the frame was decoded
+};
+
+// A rendered frame waiting for the output thread. 'cells' keeps its allocation from frame to frame.
+struct RenderedFrame
+{
+    CellGrid cells; // The output thread sends only the cells that differ from the frame on screen
+    Clock::duration pts{0};
+    Clock::time_point decode_start;
+    Clock::time_point decoded;
+    Clock::time_point render_start; // When the worker had the frame and a free output slot
+    Clock::time_point resized;
+    Clock::time_point rendered;
+    size_t decode_queue_depth = 0; // Decoded frames waiting behind this one when its rendering started
+    size_t bandwidth_rung = 0;     // Bandwidth quality rung the frame was rendered on
+    size_t render_rung = 0;        // Render time quality rung the frame was rendered on
+    bool interlace = false;        // Only every other row of the frame is to be sent
+};
+
+// Per-size resize state of one render worker, kept while the frame size and the terminal size stay the same
+struct FrameResizer
+{
+    ResizePlan plan;
+    Image resized;                    // Output buffer, reused from frame to frame
+    uint64_t terminal_generation = 0; // terminalSizeGeneration() the target was computed for
+    int source_width = 0;             // Frame size the target was computed for
+    int source_height = 0;
+    int grid_percent = 100;           // Quality rung's grid size the target was computed for
+    int target_width = 0;             // Output grid size in pixels
+    int target_height = 0;
+};
+
+// One render worker and the rings connecting it to the decode thread and the output thread.
+// Frame n goes to lane n % lanes, so every ring has a single producer and a single consumer
+// and the output thread gets frames back in order by visiting the lanes in turn.
+struct RenderLane
+{
+    SpscRing<DecodedFrame> decoded;
+    SpscRing<RenderedFrame> rendered;
+    std::string error;     // Set by the worker if rendering failed
+    FrameResizer resizer;  // Owned by the worker
+    AsciiArtParams params; // The user's parameters with the current quality rung applied (owned by the worker)
+
+    RenderLane(size_t decode_slots, size_t render_slots) : decoded(decode_slots), rendered(render_slots) {}
+};
+
+// Wall-clock schedule shared by the pipeline threads: a frame with presentation time pts is due at epoch + pts.
+// Deadlines are absolute, so sleeping and rendering errors don't accumulate from frame to frame.
+// The output thread starts the schedule when it shows the first frame; until then no frame is late.
+class PlaybackSchedule
+{
+public:
+    // True once the first frame has been shown
+    bool started() const { return epoch.load(std::memory_order_acquire) != 0; }
+
+    // Anchor the schedule so that the frame at 'pts' is due at 'when'
+    void start(Clock::duration pts, Clock::time_point when)
+    {
+        epoch.store((when - pts).time_since_epoch().count(), std::memory_order_release);
+    }
+
+    // Deadline of the frame at 'pts' (only meaningful once started)
+    Clock::time_point deadline(Clock::duration pts) const
+    {
+        return Clock::time_point(Clock::duration(epoch.load(std::memory_order_acquire))) + pts;
+    }
+
+    // Push every later deadline back, so frames keep their spacing after playback ran late
+    void delay(Clock::duration by) { epoch.fetch_add(by.count(), std::memory_order_acq_rel); }
+
+private:
+    std::atomic<Clock::rep> epoch{0}; // Deadline of pts 0 since the clock's epoch; 0 until started
+};
+
+// Presentation times of the frames read from a capture, relative to the first frame.
+// With container timestamps (CAP_PROP_POS_MSEC) variable-frame-rate files keep their timing; otherwise
+// frame n is at n * period. A timestamp that is missing or doesn't move forward is replaced by the
+// previous frame's time plus the nominal period. Used by the decode thread only.
+class PresentationClock
+{
+public:
+    PresentationClock(Clock::duration period, bool use_timestamps) : period(period), use_timestamps(use_timestamps) {}
+
+    // Time frames from the start of the file rather than from the first frame read, for a capture that was
+    // positioned at 'first_frame' (so the segments of a video get the times they have in the whole file)
+    void startAt(size_t first_frame)
+    {
+        from_file_start = true;
+        start = period * static_cast<Clock::rep>(first_frame);
+    }
+
+    // Presentation time of the frame the capture has just grabbed
+    Clock::duration next(cv::VideoCapture &cap)
+    {
+        Clock::duration pts = frames == 0 ? start : last + period;
+        if (use_timestamps)
+        {
+            double ms = cap.get(cv::CAP_PROP_POS_MSEC);
+            if (frames == 0 && !from_file_start)
+            {
+                first_ms = ms;
+            }
+            auto stamped = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms - first_ms));
+            if (frames == 0 || stamped > last)
+            {
+                pts = stamped;
+            }
+        }
+        last = pts;
+        frames++;
+        return pts;
+    }
+
+private:
+    Clock::duration period;  // Nominal time between frames
+    bool use_timestamps;     // Follow the container's timestamps
+    double first_ms = 0.0;   // Timestamp of the first frame (0 when timing from the start of the file)
+    bool from_file_start = false;
+    Clock::duration start{0}; // Presentation time of the first frame read
+    Clock::duration last{0}; // Presentation time of the previous frame
+    size_t frames = 0;       // Frames seen so far
+};
+
+// State shared by the threads of one playback
+struct VideoContext
+{
+    cv::VideoCapture &cap;
+    const AsciiArtParams &params;
+    std::vector<std::unique_ptr<RenderLane>> lanes;
+    PlaybackSchedule schedule;
+    PresentationClock presentation; // Decode thread only
+    bool drop_late; // Real-time mode: skip frames whose deadline has passed instead of playing late
+    size_t frame_limit = std::numeric_limits<size_t>::max(); // Frames the decode thread reads at most (a segment)
+
+    std::atomic<bool> stop{false};
+    std::atomic<Clock::rep> latency{0}; // Smoothed decode + render time per frame, updated by the render workers
+    std::atomic<Clock::rep> output_backlog{0}; // Time the terminal needs to drain its output queue (output thread)
+    std::atomic<size_t> skipped{0};     // Late frames grabbed without being decoded (decode thread)
+    size_t dropped = 0;                 // Rendered frames that were late for display (output thread only)
+    size_t backpressure_dropped = 0;    // Rendered frames skipped because the terminal was still busy (output thread only)
+    std::unique_ptr<QualityLadder> bandwidth; // Quality ladder for the byte budget, if any (stepped by the output thread)
+    std::atomic<size_t> bandwidth_rung{0};    // The ladder's current rung, read by the render workers
+    std::unique_ptr<QualityLadder> render;    // Quality ladder for the render time budget, if any (same)
+    std::atomic<size_t> render_rung{0};
+
+    VideoContext(cv::VideoCapture &cap, const AsciiArtParams &params, const PresentationClock &presentation, bool drop_late)
+        : cap(cap), params(params), presentation(presentation), drop_late(drop_late) {}
+};
+
+// Wall-clock time spent in each stage of one frame, in milliseconds
+struct FrameTimings
+{
+    double decode = 0.0; // Reading the frame from the decoder
+    double resize = 0.0; // Downscaling the decoder's buffer to the output grid
+    double render = 0.0; // Edge detection and text generation
+    double queued = 0.0; // Waiting in the rings between the stages and for the frame's deadline
+    double output = 0.0; // Encoding the frame and writing it to the terminal
+    double total = 0.0;  // Decode start to the frame being on the terminal
+    size_t decode_queue_depth = 0; // Decoded frames waiting behind this one when its rendering started
+    size_t render_queue_depth = 0; // Rendered frames waiting for the output thread when it took this frame
+    size_t bytes = 0;              // Bytes sent to the terminal
+    size_t full_bytes = 0;         // Bytes the frame would have taken sent in full
+    size_t writes = 0;             // write() system calls used to send the frame
+};
+
+// Milliseconds between two time points
+static double elapsedMs(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// Print per-stage averages, queue depths and the decode-to-render latency distribution of a playback
+static void printVideoStats(std::vector<FrameTimings> &timings, const VideoContext &ctx, double seconds)
+{
+    const size_t workers = ctx.lanes.size();
+    if (timings.empty())
+    {
+        return;
+    }
+    uint64_t plans = 0;
+    for (const auto &lane : ctx.lanes)
+    {
+        plans += lane->resizer.plan.rebuilds();
+    }
+
+    FrameTimings sum;
+    size_t max_decode_depth = 0;
+    size_t max_render_depth = 0;
+    for (const FrameTimings &t : timings)
+    {
+        sum.decode += t.decode;
+        sum.resize += t.resize;
+        sum.render += t.render;
+        sum.queued += t.queued;
+        sum.output += t.output;
+        sum.decode_queue_depth += t.decode_queue_depth;
+        sum.render_queue_depth += t.render_queue_depth;
+        sum.bytes += t.bytes;
+        sum.full_bytes += t.full_bytes;
+        sum.writes += t.writes;
+        max_decode_depth = std::max(max_decode_depth, t.decode_queue_depth);
+        max_render_depth = std::max(max_render_depth, t.render_queue_depth);
+    }
+    const double n = static_cast<double>(timings.size());
+
+    // Latency percentiles (nearest rank)
+    std::sort(timings.begin(), timings.end(),
+              [](const FrameTimings &a, const FrameTimings &b) { return a.total < b.total; });
+    auto percentile = [&timings](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(timings.size())));
+        return timings[std::min(std::max<size_t>(rank, 1), timings.size()) - 1].total;
+    };
+
+    std::cerr << std::fixed << std::setprecision(2)
+              << "Frames: " << timings.size() << " in " << seconds << "s ("
+              << (seconds > 0 ? n / seconds : 0.0) << " fps) with " << workers << " render worker"
+              << (workers == 1 ? "" : "s") << "\n"
+              << "Average per frame: decode " << sum.decode / n << " ms, resize " << sum.resize / n
+              << " ms, render " << sum.render / n << " ms, queued " << sum.queued / n << " ms, output "
+              << sum.output / n << " ms\n"
+              << "Decode-to-render latency: p50 " << percentile(0.50) << " ms, p95 " << percentile(0.95)
+              << " ms, max " << timings.back().total << " ms\n"
+              << "Queue depth (avg/max per worker): decoded " << static_cast<double>(sum.decode_queue_depth) / n
+              << "/" << max_decode_depth << " of " << ctx.lanes.front()->decoded.capacity()
+              << ", rendered " << static_cast<double>(sum.render_queue_depth) / n << "/" << max_render_depth
+              << " of " << ctx.lanes.front()->rendered.capacity() << "\n"
+              << "Output: " << static_cast<double>(sum.bytes) / n << " bytes/frame, "
+              << static_cast<double>(sum.full_bytes) / n << " as full frames ("
+              << (sum.full_bytes > 0 ? 100.0 * (1.0 - static_cast<double>(sum.bytes) / static_cast<double>(sum.full_bytes)) : 0.0)
+              << "% saved by delta and sparse encoding), " << static_cast<double>(sum.writes) / n
+              << " write calls/frame\n"
+              << "Resize plans built: " << plans << " (rebuilt on frame or terminal size changes)\n"
+              << "Dropped frames: " << ctx.skipped.load() + ctx.dropped + ctx.backpressure_dropped << " ("
+              << ctx.skipped.load() << " skipped before decoding, " << ctx.dropped << " after rendering, "
+              << ctx.backpressure_dropped << " for output backpressure)" << std::endl;
+}
+
+// How closely frames went on screen at their deadlines
+struct PacingStats
+{
+    std::vector<double> jitter;    // |write start - deadline| per shown frame, in milliseconds
+    Clock::duration first_pts{0};  // Presentation time of the first shown frame
+    Clock::duration last_pts{0};   // Presentation time of the last shown frame
+    Clock::time_point first_shown; // When the first frame was written
+    Clock::time_point last_shown;  // When the last frame was written
+
+    // Record one shown frame
+    void record(Clock::duration pts, Clock::time_point shown, Clock::duration lateness)
+    {
+        if (jitter.empty())
+        {
+            first_pts = pts;
+            first_shown = shown;
+        }
+        last_pts = pts;
+        last_shown = shown;
+        jitter.push_back(std::abs(std::chrono::duration<double, std::milli>(lateness).count()));
+    }
+
+    // Print jitter (distance of each frame from its deadline) and drift (how far the whole playback
+    // ended up from the file's own timing)
+    void print(bool timestamps, double period_ms)
+    {
+        if (jitter.empty())
+        {
+            return;
+        }
+        double sum = 0.0;
+        for (double j : jitter)
+        {
+            sum += j;
+        }
+        std::sort(jitter.begin(), jitter.end());
+        size_t p95 = static_cast<size_t>(std::ceil(0.95 * static_cast<double>(jitter.size())));
+        double drift = elapsedMs(first_shown, last_shown) - std::chrono::duration<double, std::milli>(last_pts - first_pts).count();
+
+        std::cerr << std::fixed << std::setprecision(2)
+                  << "Pacing (" << (timestamps ? "container timestamps" : "fixed period") << ", nominal "
+                  << period_ms << " ms/frame): jitter avg " << sum / static_cast<double>(jitter.size())
+                  << " ms, p95 " << jitter[std::max<size_t>(p95, 1) - 1] << " ms, max " << jitter.back()
+                  << " ms; drift " << std::showpos << drift << std::noshowpos << " ms over "
+                  << elapsedMs(first_shown, last_shown) / 1000.0 << "s" << std::endl;
+    }
+};
+
+// --- Pipeline Stages ---
+
+// Decode thread: reads frames into the lanes' free slots in turn until the file ends or playback stops
+// In real-time mode, frames that are already due are skipped with grab() alone, so they are never
+// decoded into pixels, resized or rendered.
+static void videoDecodeThread(VideoContext &ctx)
+{
+    for (size_t index = 0; index < ctx.frame_limit && !ctx.stop.load(); index++)
+    {
+        RenderLane &lane = *ctx.lanes[index % ctx.lanes.size()];
+
+        // Wait for the worker to free a slot
+        DecodedFrame *slot = nullptr;
+        unsigned int attempt = 0;
+        while ((slot = lane.decoded.tryAcquireWrite()) == nullptr && !ctx.stop.load())
+        {
+            ringBackoff(attempt);
+        }
+        if (slot == nullptr)
+        {
+            break;
+        }
+
+        // Grab frames until one can still be decoded and rendered before its deadline, counting the time
+        // a backed-up terminal needs before it can show anything new.
+        // Late frames are only grabbed, never retrieved, so they cost no pixel conversion.
+        bool more = true;
+        const Clock::duration latency(ctx.latency.load(std::memory_order_relaxed) +
+                                      ctx.output_backlog.load(std::memory_order_relaxed));
+        while (true)
+        {
+            slot->decode_start = Clock::now();
+            if (!ctx.cap.grab())
+            {
+                more = false;
+                break;
+            }
+            slot->pts = ctx.presentation.next(ctx.cap);
+            if (!ctx.drop_late || !ctx.schedule.started() ||
+                Clock::now() + latency < ctx.schedule.deadline(slot->pts))
+            {
+                break;
+            }
+            ctx.skipped++;
+        }
+
+        if (!more || !ctx.cap.retrieve(slot->frame) || slot->frame.empty())
+        {
+            break; // End of file
+        }
+        slot->decoded = Clock::now();
+        lane.decoded.commitWrite();
+    }
+
+    // Lanes are closed together: frame n missing means no later frame exists either
+    for (auto &lane : ctx.lanes)
+    {
+        lane->decoded.close();
+    }
+}
+
+// Resize one decoded frame to the output grid and render it to text
+// quality: The quality rung to render on (params already has its color and edge settings applied)
+static void renderVideoFrame(const DecodedFrame &in, const AsciiArtParams &params, const QualitySettings &quality,
+                             FrameResizer &resizer, RenderedFrame &out)
+{
+    // Downscale straight from the decoder's BGR buffer; any color conversion happens on the output grid
+    ImageView frame_view = matToImageView(in.frame);
+
+    // The output grid only changes with the frame size, the quality rung's grid size or, when fitting,
+    // the terminal size. Until then the resize plan and buffer from the previous frame are reused as they are.
+    uint64_t generation = params.auto_fit ? terminalSizeGeneration() : 0;
+    if (resizer.source_width != frame_view.width || resizer.source_height != frame_view.height ||
+        generation != resizer.terminal_generation || resizer.grid_percent != quality.grid_percent)
+    {
+        if (params.auto_fit)
+        {
+            fitToTerminal(frame_view.width, frame_view.height, params.aspect_ratio, currentTerminalSize(),
+                          resizer.target_width, resizer.target_height);
+        }
+        else
+        {
+            // Same dimensions as resizeImage with the user's scale
+            resizer.target_width = static_cast<int>(static_cast<float>(frame_view.width) / params.scale);
+            resizer.target_height = static_cast<int>(static_cast<float>(frame_view.height) / params.scale / params.aspect_ratio);
+        }
+        if (quality.grid_percent < 100)
+        {
+            resizer.target_width = std::max(resizer.target_width * quality.grid_percent / 100, 1);
+            resizer.target_height = std::max(resizer.target_height * quality.grid_percent / 100, 1);
+        }
+        resizer.source_width = frame_view.width;
+        resizer.source_height = frame_view.height;
+        resizer.terminal_generation = generation;
+        resizer.grid_percent = quality.grid_percent;
+    }
+    if (quality.fast_resize && resizer.target_height > 0)
+    {
+        // Filter only every few source rows, keeping two per output row: a row step over the same buffer,
+        // so the rows in between are never read (the frame stays alive in 'in' for the call)
+        const int row_step = frame_view.height / (2 * resizer.target_height);
+        if (row_step > 1)
+        {
+            frame_view = ImageView(frame_view.data, frame_view.width, frame_view.height / row_step, frame_view.channels,
+                                   frame_view.stride * static_cast<size_t>(row_step), frame_view.order);
+        }
+    }
+    resizer.plan.resize(frame_view, resizer.target_width, resizer.target_height, resizer.resized);
+    const Image &img = resizer.resized;
+    out.resized = Clock::now();
+
+    // Edge detection if enabled
+    std::vector<float> edge_magnitudes;
+    const std::vector<float> *edge_magnitudes_ptr = nullptr;
+
+    if (params.detect_edges)
+    {
+        edge_magnitudes = detectEdges(img);
+        edge_magnitudes_ptr = &edge_magnitudes;
+    }
+
+    // Render into the slot's cell grid
+    generateCellGrid(img, params, edge_magnitudes_ptr, out.cells);
+    reduceGridColors(out.cells, quality);
+    out.rendered = Clock::now();
+    out.interlace = quality.interlace;
+
+    out.pts = in.pts;
+    out.decode_start = in.decode_start;
+    out.decoded = in.decoded;
+}
+
+// Render worker: turns the lane's decoded frames into text until the decode thread closes the lane
+static void videoRenderWorker(VideoContext &ctx, RenderLane &lane)
+{
+    std::atomic<bool> &stop = ctx.stop;
+    lane.params = ctx.params;
+    while (!stop.load())
+    {
+        // Wait for a decoded frame; once the lane is closed, one more look catches frames published before closing
+        DecodedFrame *in = nullptr;
+        unsigned int attempt = 0;
+        while ((in = lane.decoded.tryAcquireRead()) == nullptr && !stop.load())
+        {
+            if (lane.decoded.isClosed())
+            {
+                in = lane.decoded.tryAcquireRead();
+                break;
+            }
+            ringBackoff(attempt);
+        }
+        if (in == nullptr)
+        {
+            break;
+        }
+        // Wait for the output thread to free a slot
+        RenderedFrame *out = nullptr;
+        attempt = 0;
+        while ((out = lane.rendered.tryAcquireWrite()) == nullptr && !stop.load())
+        {
+            ringBackoff(attempt);
+        }
+        if (out == nullptr)
+        {
+            break;
+        }
+        size_t waiting = lane.decoded.depth() - 1;
+        out->render_start = Clock::now();
+
+        // Render on the quality rungs the output thread last picked
+        QualitySettings quality;
+        out->bandwidth_rung = 0;
+        out->render_rung = 0;
+        if (ctx.bandwidth)
+        {
+            out->bandwidth_rung = ctx.bandwidth_rung.load(std::memory_order_relaxed);
+            quality = ctx.bandwidth->rungs()[out->bandwidth_rung].settings;
+        }
+        if (ctx.render)
+        {
+            out->render_rung = ctx.render_rung.load(std::memory_order_relaxed);
+            quality = combineQuality(quality, ctx.render->rungs()[out->render_rung].settings);
+        }
+        lane.params.color = ctx.params.color && quality.color_depth != ColorDepth::None;
+        lane.params.detect_edges = ctx.params.detect_edges && quality.edges;
+
+        try
+        {
+            renderVideoFrame(*in, lane.params, quality, lane.resizer, *out);
+        }
+        catch (const std::exception &e)
+        {
+            lane.error = e.what();
+            stop.store(true);
+            break;
+        }
+        out->decode_queue_depth = waiting;
+
+        // Smoothed time to decode and render a frame (1/4 weight for the newest frame), used by the decode
+        // thread to skip ahead. Time spent queued is left out: it only grows when playback is ahead of schedule.
+        // Workers may race on the update; it is only an estimate.
+        Clock::rep sample = ((out->decoded - out->decode_start) + (out->rendered - out->render_start)).count();
+        Clock::rep smoothed = ctx.latency.load(std::memory_order_relaxed);
+        ctx.latency.store(smoothed == 0 ? sample : smoothed + (sample - smoothed) / 4, std::memory_order_relaxed);
+
+        lane.decoded.commitRead();
+        lane.rendered.commitWrite();
+    }
+
+    lane.rendered.close();
+}
+
+// Wait for the lane's next rendered frame
+// Returns: The frame, or nullptr once the lane is closed and empty (end of file, or a worker failed)
+static RenderedFrame *waitForRenderedFrame(RenderLane &lane)
+{
+    RenderedFrame *frame = nullptr;
+    unsigned int attempt = 0;
+    while ((frame = lane.rendered.tryAcquireRead()) == nullptr)
+    {
+        if (lane.rendered.isClosed())
+        {
+            // One more look catches frames published before closing
+            return lane.rendered.tryAcquireRead();
+        }
+        ringBackoff(attempt);
+    }
+    return frame;
+}
+
+// Number of render workers to start
+// requested: The user's choice, or 0 to pick from the hardware concurrency
+// exporting: Workers for an export rather than playback
+static unsigned int renderWorkerCount(unsigned int requested, bool exporting)
+{
+    if (requested > 0)
+    {
+        return requested;
+    }
+    // Leave a core for decoding, and one for output when playing (an export's sink is cheap next to rendering)
+    unsigned int cores = std::thread::hardware_concurrency();
+    unsigned int reserved = exporting ? 1u : 2u;
+    return std::min(cores > reserved ? cores - reserved : 1u, exporting ? constants::VIDEO_MAX_DEFAULT_EXPORT_WORKERS
+                                                                        : constants::VIDEO_MAX_DEFAULT_RENDER_WORKERS);
+}
+
+// Create one render lane per worker. The lanes are also the reorder buffer: frame n goes to lane n % lanes and
+// the output side visits the lanes in turn, so frames come out in order however the workers' speeds differ.
+// ctx: Receives the lanes
+// workers: Render workers wanted
+// max_in_flight: Most decoded and rendered frames held at once across all lanes, or 0 for the default slots
+// Returns: The lanes created; fewer than 'workers' when the limit can't give each one a decode and a render slot
+static unsigned int createRenderLanes(VideoContext &ctx, unsigned int workers, size_t max_in_flight)
+{
+    size_t decode_slots = constants::VIDEO_DECODE_SLOTS_PER_WORKER;
+    size_t render_slots = constants::VIDEO_RENDER_SLOTS_PER_WORKER;
+    if (max_in_flight > 0)
+    {
+        workers = static_cast<unsigned int>(std::max<size_t>(std::min<size_t>(workers, max_in_flight / 2), 1));
+        const size_t share = std::max<size_t>(max_in_flight / workers, 2);
+        decode_slots = share / 2;
+        render_slots = share - decode_slots;
+    }
+    for (unsigned int w = 0; w < workers; w++)
+    {
+        ctx.lanes.push_back(std::make_unique<RenderLane>(decode_slots, render_slots));
+    }
+    return workers;
+}
+
+// Nominal time between frames: the file's frame rate with the auto delay, otherwise the user's delay
+static std::chrono::duration<double, std::milli> framePeriod(cv::VideoCapture &cap, const VideoOptions &options)
+{
+    if (options.frame_delay != VideoOptions::AUTO_DELAY)
+    {
+        return std::chrono::duration<double, std::milli>(static_cast<double>(options.frame_delay));
+    }
+    double fps = cap.get(cv::CAP_PROP_FPS);
+    return std::chrono::duration<double, std::milli>(fps > 0 ? 1000.0 / fps : constants::VIDEO_FALLBACK_DELAY_MS);
+}
+
+// --- Video Processing Implementation ---
+
+// View an OpenCV Mat as an ImageView
+// The view holds a reference to the Mat's buffer (Mat headers are reference counted), so no pixels are copied.
+// OpenCV frames are BGR(A); the view is tagged as such, so resizing and luma read BGR directly and
+// the swap to RGB happens per output cell.
+ImageView matToImageView(const cv::Mat &mat)
+{
+    // The Mat's row step covers non-continuous Mats (e.g. ROIs) as well
+    ImageView img(mat.data, mat.cols, mat.rows, mat.channels(), mat.step, ChannelOrder::BGR);
+    img.keep_alive = std::make_shared<cv::Mat>(mat);
+    return img;
+}
+
+// Check if file is a supported video/GIF format
+// Supports common video formats and animated GIFs
+bool isVideoFile(const std::string &filename)
+{
+    // Convert filename to lowercase for case-insensitive comparison
+    std::string lower = filename;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    // Check for supported video and GIF extensions
+    return (lower.find(".mp4") != std::string::npos ||
+            lower.find(".avi") != std::string::npos ||
+            lower.find(".mov") != std::string::npos ||
+            lower.find(".mkv") != std::string::npos ||
+            lower.find(".webm") != std::string::npos ||
+            lower.find(".gif") != std::string::npos ||
+            lower.find(".m4v") != std::string::npos ||
+            lower.find(".wmv") != std::string::npos ||
+            lower.find(".flv") != std::string::npos);
+}
+
+// Process video/GIF file with smooth playback and proper frame buffer management
+// The calling thread is the output thread: it only writes and paces frames, while a decode thread and
+// the render workers keep the rings ahead of it. In real-time mode frames that miss their deadline are
+// dropped, so playback keeps the file's speed on a slow machine instead of falling behind.
+bool processVideo(const std::string &videoFile,
+                  const AsciiArtParams &params,
+                  const VideoOptions &options)
+{
+    cv::VideoCapture cap(videoFile);
+    if (!cap.isOpened())
+    {
+        std::cerr << "Failed to open video/GIF file: " << videoFile << std::endl;
+        return false;
+    }
+
+    // Auto delay follows the file: container timestamps, with the nominal frame rate as fallback.
+    // An explicit delay paces frames at a fixed period instead.
+    const bool auto_delay = options.frame_delay == VideoOptions::AUTO_DELAY;
+    const std::chrono::duration<double, std::milli> period_ms = framePeriod(cap, options);
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(period_ms);
+
+    // Without a frame period (-d 0) there are no deadlines to miss
+    VideoContext ctx(cap, params, PresentationClock(period, auto_delay), options.drop_late_frames && period.count() > 0);
+    const unsigned int workers = createRenderLanes(ctx, renderWorkerCount(options.render_workers, false), options.max_in_flight);
+    auto &lanes = ctx.lanes;
+    if (options.max_bytes_per_sec > 0)
+    {
+        ctx.bandwidth = std::make_unique<QualityLadder>(bandwidthLadder(params));
+    }
+    // The workers render in parallel, so each of them has that many frame periods per frame
+    const double render_budget_ms = options.render_budget_ms == VideoOptions::AUTO_RENDER_BUDGET
+                                        ? period_ms.count() * static_cast<double>(workers)
+                                        : options.render_budget_ms;
+    if (render_budget_ms > 0)
+    {
+        ctx.render = std::make_unique<QualityLadder>(renderLadder(params));
+    }
+
+    // Workers keep their resize plans until the terminal is actually resized
+    startTerminalSizeTracking();
+
+    // Frames are wrapped in synchronized updates when the terminal supports them (asked before the
+    // screen is set up, while the terminal is still in its normal state)
+    const bool synchronized = querySynchronizedUpdates(constants::VIDEO_SYNC_QUERY_TIMEOUT_MS);
+
+    // Terminal initialization
+    writeStdout(PLAYBACK_SCREEN_SETUP);
+
+    // --- Start the Pipeline ---
+    auto start = Clock::now();
+    std::thread decoder(videoDecodeThread, std::ref(ctx));
+    std::vector<std::thread> renderers;
+    for (auto &lane : lanes)
+    {
+        renderers.emplace_back(videoRenderWorker, std::ref(ctx), std::ref(*lane));
+    }
+
+    CellGrid shown;                          // The frame on the terminal, to diff the next one against
+    uint64_t shown_generation = terminalSizeGeneration();
+    std::string frame_bytes;                 // Everything sent for one frame, reused
+    std::string full_frame;                  // Statistics only: the frame as a full redraw
+    std::unique_ptr<VirtualScreen> verifier; // Replays the output when verification was requested
+    size_t verified = 0;
+    size_t mismatches = 0;
+    std::string first_mismatch;
+    std::string output_error; // Set if writing to the terminal failed
+
+    // Output queue tracking, for terminals only (files and pipes have no tty queue)
+    const bool watch_output = stdoutIsTerminal();
+    size_t queued_after_write = 0; // Terminal output queue after the last write (or skip)
+    Clock::time_point last_write;  // When that was measured
+    double drain_rate = 0.0;       // Smoothed bytes per second the terminal reads while backed up (0 = unknown)
+    size_t max_output_queue = 0;   // Largest output queue seen when a frame was due
+    Clock::time_point output_ready; // Until then the terminal is still busy with earlier frames
+    size_t blocked_writes = 0;      // Writes that blocked because the terminal was backed up
+
+    // Byte budget bookkeeping
+    int interlace_phase = 0;         // Row parity the next interlaced frame updates
+    size_t sent_bytes = 0;           // Bytes of all frames written
+    size_t shown_frames = 0;         // Frames written
+    size_t budget_reached = 0;       // Frames written before the first one within budget (0 = none yet)
+    Clock::time_point first_write;   // When the first frame was written
+    Clock::time_point previous_write; // When the previous frame was written
+    std::vector<FrameTimings> timings; // Filled only when statistics were requested
+    PacingStats pacing;
+    if (options.verify_output)
+    {
+        verifier = std::make_unique<VirtualScreen>(1, 1); // Starts cleared, like the terminal; grows with the frames
+    }
+
+    for (size_t index = 0;; index++)
+    {
+        // Frames come back in order by visiting the lanes in turn
+        RenderLane &lane = *lanes[index % lanes.size()];
+        RenderedFrame *frame = waitForRenderedFrame(lane);
+        if (frame == nullptr)
+        {
+            break; // End of file (or a worker failed)
+        }
+        size_t waiting = lane.rendered.depth() - 1;
+        auto taken = Clock::now();
+
+        // --- Timing Control ---
+        // The first frame shown starts the schedule; every later frame waits for its own deadline
+        if (!ctx.schedule.started())
+        {
+            ctx.schedule.start(frame->pts, taken);
+        }
+        auto due = ctx.schedule.deadline(frame->pts);
+        // Only a frame a whole period late is worth dropping; less than that is jitter
+        if (ctx.drop_late && taken >= due + period)
+        {
+            // A newer frame that is already due and rendered replaces this one; without one, show this one late.
+            // With a single lane the newer frame sits behind this one in the same ring.
+            const RenderedFrame *next = lanes.size() == 1 ? lane.rendered.peek(1)
+                                                          : lanes[(index + 1) % lanes.size()]->rendered.peek(0);
+            if (next != nullptr && taken >= ctx.schedule.deadline(next->pts))
+            {
+                ctx.dropped++;
+                lane.rendered.commitRead();
+                continue;
+            }
+        }
+        if (taken < due)
+        {
+            std::this_thread::sleep_until(due);
+        }
+        else if (!ctx.drop_late)
+        {
+            // Playing every frame: shift the schedule instead of rushing the following frames
+            ctx.schedule.delay(taken - due);
+        }
+        auto writeStart = Clock::now();
+
+        // --- Output Backpressure ---
+        // A terminal that hasn't finished reading the previous frame when the next one is due can't keep up
+        // (a slow pty or a congested SSH link). Writing more would only queue stale frames behind it, so in
+        // real-time mode frames are skipped until it has caught up, and the decode thread is told how long
+        // that will take so it doesn't decode and render frames that would be skipped anyway.
+        // Two signals are used: the tty's output queue (TIOCOUTQ, where the driver reports it; Linux ptys
+        // always report 0) and the time the last write blocked, which says the terminal's buffer is full.
+        if (watch_output)
+        {
+            size_t queued = pendingStdoutBytes();
+            if (queued > 0 && queued < queued_after_write)
+            {
+                // The terminal was busy the whole time: what it drained measures the link's throughput
+                double sample = static_cast<double>(queued_after_write - queued) /
+                                std::chrono::duration<double>(writeStart - last_write).count();
+                drain_rate = drain_rate > 0 ? drain_rate + (sample - drain_rate) / 4 : sample;
+            }
+            max_output_queue = std::max(max_output_queue, queued);
+
+            Clock::time_point ready = output_ready;
+            if (queued > 0)
+            {
+                Clock::duration drain = period;
+                if (drain_rate > 0)
+                {
+                    drain = std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::duration<double>(static_cast<double>(queued) / drain_rate));
+                }
+                ready = std::max(ready, writeStart + drain);
+            }
+
+            if (ctx.drop_late && writeStart < ready && !shown.cells.empty())
+            {
+                ctx.output_backlog.store((ready - writeStart).count(), std::memory_order_relaxed);
+                ctx.backpressure_dropped++;
+                queued_after_write = queued;
+                last_write = writeStart;
+                lane.rendered.commitRead();
+                continue;
+            }
+            ctx.output_backlog.store(0, std::memory_order_relaxed);
+        }
+
+        // --- Frame Encoding ---
+        // Frames of the same size only send the cells that changed. The first frame, a frame of a new size
+        // and the frame after a terminal resize (which may have reflowed the screen) are drawn in full
+        // on a cleared screen.
+        CellGrid &cells = frame->cells;
+        const uint64_t generation = terminalSizeGeneration();
+        const bool delta = !shown.cells.empty() && cells.width == shown.width && cells.height == shown.height &&
+                           generation == shown_generation;
+        frame_bytes.clear();
+        if (synchronized)
+        {
+            frame_bytes += SYNC_UPDATE_BEGIN;
+        }
+        if (delta)
+        {
+            if (frame->interlace)
+            {
+                // Interlaced quality rung: the rows of the other parity keep what the terminal shows
+                for (int y = interlace_phase ^ 1; y < cells.height; y += 2)
+                {
+                    std::copy(shown.row(y), shown.row(y) + cells.width, cells.row(y));
+                }
+                interlace_phase ^= 1;
+            }
+            appendGridDelta(shown, cells, frame_bytes);
+        }
+        else
+        {
+            // Start from a blank screen so the sparse encoding can skip blanks (the screen was
+            // cleared when playback started)
+            if (!shown.cells.empty())
+            {
+                frame_bytes += "\033[2J";
+            }
+            frame_bytes += "\033[1;1H"; // Go to top-left
+            appendGridSparse(cells, frame_bytes);
+        }
+        if (synchronized)
+        {
+            frame_bytes += SYNC_UPDATE_END;
+        }
+
+        // Display the frame: cursor moves, clears and cells go out in a single write, so the terminal
+        // never shows a half-updated frame between system calls
+        size_t writes = 0;
+        try
+        {
+            writes = writeStdout(frame_bytes);
+        }
+        catch (const std::exception &e)
+        {
+            output_error = e.what();
+            lane.rendered.commitRead();
+            break;
+        }
+        pacing.record(frame->pts, writeStart, writeStart - due);
+
+        // --- Render Budget ---
+        // The frame's resize and render time against the budget; the ladder keeps rendering real-time
+        const double playback_seconds = std::chrono::duration<double>(writeStart - pacing.first_shown).count();
+        if (ctx.render)
+        {
+            if (ctx.render->record(frame->render_rung, elapsedMs(frame->render_start, frame->rendered) / render_budget_ms))
+            {
+                ctx.render_rung.store(ctx.render->rung(), std::memory_order_relaxed);
+            }
+            ctx.render->logShown(playback_seconds, frame->render_rung);
+        }
+
+        // --- Byte Budget ---
+        // Each frame is measured against the budget for the time since the previous frame (at least one
+        // frame period), and the quality ladder steps to a rung whose frames fit. Full redraws are left out:
+        // they only happen on size changes and would make a one-off spike look like the norm.
+        if (ctx.bandwidth)
+        {
+            if (shown_frames == 0)
+            {
+                first_write = writeStart;
+            }
+            else if (delta)
+            {
+                Clock::duration interval = std::max(period, writeStart - previous_write);
+                double usage = static_cast<double>(frame_bytes.size()) /
+                               (static_cast<double>(options.max_bytes_per_sec) * std::chrono::duration<double>(interval).count());
+                if (budget_reached == 0 && usage <= 1.0)
+                {
+                    budget_reached = shown_frames;
+                }
+                if (ctx.bandwidth->record(frame->bandwidth_rung, usage))
+                {
+                    ctx.bandwidth_rung.store(ctx.bandwidth->rung(), std::memory_order_relaxed);
+                }
+            }
+            sent_bytes += frame_bytes.size();
+            previous_write = writeStart;
+            ctx.bandwidth->logShown(playback_seconds, frame->bandwidth_rung);
+        }
+        shown_frames++;
+        if (watch_output)
+        {
+            // Roughly what the terminal has left to read now; the next frame measures how much of it drained
+            queued_after_write = pendingStdoutBytes();
+            last_write = Clock::now();
+
+            // A write that blocked for a good part of the frame period means the terminal's buffer was full
+            // and is still full now. Frames due in the next part of that time would block the same way, so
+            // they are skipped; holding off for the whole time would leave the link idle once the buffer drains.
+            Clock::duration blocked = last_write - writeStart;
+            if (blocked > period / constants::VIDEO_OUTPUT_BLOCKED_FRACTION)
+            {
+                output_ready = last_write + blocked / constants::VIDEO_OUTPUT_HOLD_FRACTION;
+                blocked_writes++;
+            }
+        }
+
+        if (verifier)
+        {
+            // Whatever the encoders sent, the screen must now show exactly this frame
+            verifier->ensureSize(cells.width, cells.height);
+            verifier->feed(frame_bytes);
+            std::string mismatch;
+            if (!verifier->matches(cells, mismatch) && mismatches++ == 0)
+            {
+                first_mismatch = "frame " + std::to_string(verified) + ": " + mismatch;
+            }
+            verified++;
+        }
+
+        if (options.show_stats)
+        {
+            auto shown_at = Clock::now();
+            FrameTimings t;
+            t.decode = elapsedMs(frame->decode_start, frame->decoded);
+            t.resize = elapsedMs(frame->render_start, frame->resized);
+            t.render = elapsedMs(frame->resized, frame->rendered);
+            t.queued = elapsedMs(frame->decoded, writeStart) - t.resize - t.render;
+            t.output = elapsedMs(writeStart, shown_at);
+            t.total = elapsedMs(frame->decode_start, shown_at);
+            t.decode_queue_depth = frame->decode_queue_depth;
+            t.render_queue_depth = waiting;
+            t.bytes = frame_bytes.size();
+            t.writes = writes;
+            full_frame.assign("\033[1;1H");
+            appendGridText(cells, full_frame);
+            t.full_bytes = full_frame.size();
+            timings.push_back(t);
+        }
+
+        // Keep the frame as the new reference; the worker gets the old reference's buffer to render into
+        std::swap(shown, frame->cells);
+        shown_generation = generation;
+
+        // Hand the slot back to the worker
+        lane.rendered.commitRead();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // --- Shut Down the Pipeline ---
+    ctx.stop.store(true);
+    decoder.join();
+    for (auto &renderer : renderers)
+    {
+        renderer.join();
+    }
+
+    // Restore and exit
+    writeStdout(PLAYBACK_SCREEN_RESTORE);
+
+    cap.release();
+
+    for (const auto &lane : lanes)
+    {
+        if (!lane->error.empty())
+        {
+            std::cerr << "Error: Failed to render frame: " << lane->error << std::endl;
+            return false;
+        }
+    }
+
+    if (!output_error.empty())
+    {
+        std::cerr << "Error: " << output_error << std::endl;
+        return false;
+    }
+
+    if (verifier)
+    {
+        if (mismatches > 0)
+        {
+            std::cerr << "Output verification failed for " << mismatches << " of " << verified << " frames (first: "
+                      << first_mismatch << ")" << std::endl;
+            return false;
+        }
+        std::cerr << "Output verified: the terminal showed every one of " << verified << " frames exactly" << std::endl;
+    }
+
+    // The achieved rate is always reported when a budget was set
+    if (ctx.bandwidth && shown_frames > 1)
+    {
+        // The last frame gets its own period to be read in
+        double sent_seconds = std::chrono::duration<double>(previous_write - first_write + period).count();
+        std::cerr << std::fixed << std::setprecision(0) << "Bandwidth: "
+                  << (sent_seconds > 0 ? static_cast<double>(sent_bytes) / sent_seconds : 0.0)
+                  << " bytes/s sent (budget " << options.max_bytes_per_sec << " bytes/s); ";
+        if (budget_reached > 0)
+        {
+            std::cerr << "frames fit from frame " << budget_reached + 1;
+        }
+        else
+        {
+            std::cerr << "no frame fit";
+        }
+        std::cerr << ", ended on '" << ctx.bandwidth->rungs()[ctx.bandwidth->rung()].name << "' after "
+                  << ctx.bandwidth->steps() << " rung changes" << std::endl;
+        ctx.bandwidth->printLog(std::cerr, "bandwidth");
+    }
+    if (ctx.render && shown_frames > 0)
+    {
+        std::cerr << std::fixed << std::setprecision(2) << "Render budget: " << render_budget_ms
+                  << " ms of resize and render time per frame; ended on '" << ctx.render->rungs()[ctx.render->rung()].name
+                  << "' after " << ctx.render->steps() << " rung changes" << std::endl;
+        ctx.render->printLog(std::cerr, "render time");
+    }
+
+    // Statistics go to stderr, after the alternate screen is gone, so they stay visible
+    if (options.show_stats)
+    {
+        printVideoStats(timings, ctx, seconds);
+        if (watch_output)
+        {
+            std::cerr << "Terminal output queue: max " << max_output_queue << " bytes when a frame was due, "
+                      << blocked_writes << " blocking writes";
+            if (drain_rate > 0)
+            {
+                std::cerr << ", drained at " << std::setprecision(0) << drain_rate << " bytes/s while backed up";
+            }
+            std::cerr << std::endl;
+        }
+        std::cerr << "Synchronized updates (DEC mode 2026): "
+                  << (synchronized ? "on" : "off (the terminal doesn't support them or didn't answer)") << std::endl;
+        pacing.print(auto_delay, period_ms.count());
+    }
+    else if (ctx.skipped.load() + ctx.dropped + ctx.backpressure_dropped > 0)
+    {
+        std::cerr << "Dropped " << ctx.skipped.load() + ctx.dropped + ctx.backpressure_dropped << " late frames to keep up";
+        if (ctx.backpressure_dropped > 0)
+        {
+            std::cerr << ", " << ctx.backpressure_dropped << " of them because the terminal couldn't take output fast enough";
+        }
+        std::cerr << " (use --no-drop to play every frame)" << std::endl;
+    }
+
+    return true;
+}
+
+// --- Headless Export ---
+
+// Where a segment's frames wait until the segments before it have been written: an anonymous temporary file
+// (removed when closed) holding each rendered frame's grid size, color flag, presentation time and cells.
+// Only frames the output isn't ready for are kept, and on disk, so memory use doesn't grow with the video.
+class SegmentSpill : public FrameSink
+{
+public:
+    // Throws: std::runtime_error if no temporary file can be created
+    SegmentSpill() : file(std::tmpfile())
+    {
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Failed to create a temporary file for a video segment");
+        }
+    }
+    ~SegmentSpill() override { std::fclose(file); }
+
+    SegmentSpill(const SegmentSpill &) = delete;
+    SegmentSpill &operator=(const SegmentSpill &) = delete;
+
+    void addFrame(const CellGrid &frame, std::chrono::nanoseconds pts) override
+    {
+        record.clear();
+        appendValue(static_cast<int32_t>(frame.width));
+        appendValue(static_cast<int32_t>(frame.height));
+        appendValue(static_cast<uint8_t>(frame.color));
+        appendValue(static_cast<int64_t>(pts.count()));
+        for (const Cell &cell : frame.cells)
+        {
+            const char packed[5] = {cell.glyph, static_cast<char>((cell.colored ? 1 : 0) | (cell.indexed ? 2 : 0)),
+                                    static_cast<char>(cell.r), static_cast<char>(cell.g), static_cast<char>(cell.b)};
+            record.append(packed, sizeof(packed));
+        }
+        if (std::fwrite(record.data(), 1, record.size(), file) != record.size())
+        {
+            throw std::runtime_error("Failed to write a video segment to a temporary file");
+        }
+        frames++;
+    }
+
+    void finish(std::chrono::nanoseconds) override {}
+
+    // Send every frame stored so far to another sink, in order
+    // Throws: std::runtime_error if the file can't be read back, or whatever the sink throws
+    void replay(FrameSink &sink)
+    {
+        std::rewind(file);
+        CellGrid grid;
+        for (size_t i = 0; i < frames; i++)
+        {
+            int32_t width = 0, height = 0;
+            uint8_t color = 0;
+            int64_t pts = 0;
+            if (!readValue(width) || !readValue(height) || !readValue(color) || !readValue(pts) || width < 0 || height < 0)
+            {
+                throw std::runtime_error("Failed to read a video segment back from its temporary file");
+            }
+            grid.width = width;
+            grid.height = height;
+            grid.color = color != 0;
+            record.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 5);
+            grid.cells.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+            if (std::fread(&record[0], 1, record.size(), file) != record.size())
+            {
+                throw std::runtime_error("Failed to read a video segment back from its temporary file");
+            }
+            for (size_t c = 0; c < grid.cells.size(); c++)
+            {
+                const char *packed = record.data() + c * 5;
+                Cell &cell = grid.cells[c];
+                cell.glyph = packed[0];
+                cell.colored = (packed[1] & 1) != 0;
+                cell.indexed = (packed[1] & 2) != 0;
+                cell.r = static_cast<uint8_t>(packed[2]);
+                cell.g = static_cast<uint8_t>(packed[3]);
+                cell.b = static_cast<uint8_t>(packed[4]);
+            }
+            sink.addFrame(grid, std::chrono::nanoseconds(pts));
+        }
+    }
+
+private:
+    template <typename T>
+    void appendValue(T value) { record.append(reinterpret_cast<const char *>(&value), sizeof(value)); }
+
+    template <typename T>
+    bool readValue(T &value) { return std::fread(&value, sizeof(value), 1, file) == 1; }
+
+    std::FILE *file;
+    std::string record; // One frame's record, reused
+    size_t frames = 0;
+};
+
+// Passes frames on with presentation times relative to the first frame, and counts them
+class RebasedSink : public FrameSink
+{
+public:
+    explicit RebasedSink(FrameSink &target) : target(target) {}
+
+    void addFrame(const CellGrid &frame, std::chrono::nanoseconds pts) override
+    {
+        if (frames == 0)
+        {
+            origin = pts;
+        }
+        target.addFrame(frame, pts - origin);
+        last_pts = pts - origin;
+        frames++;
+    }
+
+    void finish(std::chrono::nanoseconds duration) override { target.finish(duration); }
+
+    FrameSink &target;
+    std::chrono::nanoseconds origin{0};
+    std::chrono::nanoseconds last_pts{0}; // Of the last frame passed on
+    size_t frames = 0;
+};
+
+// Work and outcome of one export pipeline (the whole video, or one segment of it)
+struct ExportRun
+{
+    size_t frame_limit = std::numeric_limits<size_t>::max(); // Frames to read at most from where the capture is
+    unsigned int workers = 1;                                // Render workers asked for
+    size_t max_in_flight = 0;                                // Their in-flight frame limit (0 = default)
+    unsigned int started_workers = 0; // Render workers started
+    size_t in_flight = 0;             // Most frames the lanes could hold
+    bool ok = false;                  // Every frame was rendered and taken by the sink (otherwise an error was printed)
+};
+
+// Decode and render frames of an open capture into a sink: the playback pipeline without the schedule.
+// Nothing is late, so nothing is skipped, and the calling thread hands frames to the sink in order as soon
+// as they are rendered. The sink isn't finished, so several runs can feed one output.
+// cap: Positioned at the first frame to export
+// presentation: Timing of the frames read
+// run: What to export; receives the outcome
+static void exportFrames(cv::VideoCapture &cap, const AsciiArtParams &params, const PresentationClock &presentation,
+                         FrameSink &sink, ExportRun &run)
+{
+    VideoContext ctx(cap, params, presentation, false);
+    ctx.frame_limit = run.frame_limit;
+    run.started_workers = createRenderLanes(ctx, run.workers, run.max_in_flight);
+    run.in_flight = run.started_workers * (ctx.lanes.front()->decoded.capacity() + ctx.lanes.front()->rendered.capacity());
+
+    // --- Start the Pipeline ---
+    std::thread decoder(videoDecodeThread, std::ref(ctx));
+    std::vector<std::thread> renderers;
+    for (auto &lane : ctx.lanes)
+    {
+        renderers.emplace_back(videoRenderWorker, std::ref(ctx), std::ref(*lane));
+    }
+
+    std::string sink_error;
+    for (size_t index = 0;; index++)
+    {
+        RenderLane &lane = *ctx.lanes[index % ctx.lanes.size()];
+        RenderedFrame *frame = waitForRenderedFrame(lane);
+        if (frame == nullptr)
+        {
+            break;
+        }
+        try
+        {
+            sink.addFrame(frame->cells, frame->pts);
+        }
+        catch (const std::exception &e)
+        {
+            sink_error = e.what();
+            lane.rendered.commitRead();
+            break;
+        }
+        lane.rendered.commitRead();
+    }
+
+    // --- Shut Down the Pipeline ---
+    ctx.stop.store(true);
+    decoder.join();
+    for (auto &renderer : renderers)
+    {
+        renderer.join();
+    }
+
+    for (const auto &lane : ctx.lanes)
+    {
+        if (!lane->error.empty())
+        {
+            std::cerr << "Error: Failed to render frame: " << lane->error << std::endl;
+            return;
+        }
+    }
+    if (!sink_error.empty())
+    {
+        std::cerr << "Error: " << sink_error << std::endl;
+        return;
+    }
+    run.ok = true;
+}
+
+// Position a capture at a frame. Some backends land on a nearby keyframe when seeking by frame number,
+// so the position is checked; if it's off, the capture is seeked by time to a point a little before the frame
+// and read forward from wherever it lands. It is never read from the start of the file: that would make every
+// segment decode everything before it.
+// Returns: false if no seek lands at or before the frame (or the file ends before it)
+static bool seekToFrame(cv::VideoCapture &cap, size_t frame)
+{
+    if (frame == 0)
+    {
+        return true;
+    }
+    if (cap.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(frame)) &&
+        static_cast<size_t>(cap.get(cv::CAP_PROP_POS_FRAMES)) == frame)
+    {
+        return true;
+    }
+
+    const double fps = cap.get(cv::CAP_PROP_FPS);
+    if (!(fps > 0))
+    {
+        return false;
+    }
+    size_t backoff = constants::VIDEO_SEEK_BACKOFF_FRAMES;
+    for (int attempt = 0; attempt < constants::VIDEO_SEEK_ATTEMPTS && backoff < frame; attempt++, backoff *= 2)
+    {
+        const double target_ms = static_cast<double>(frame - backoff) * 1000.0 / fps;
+        if (!cap.set(cv::CAP_PROP_POS_MSEC, target_ms))
+        {
+            return false;
+        }
+        const double landed = cap.get(cv::CAP_PROP_POS_FRAMES);
+        if (landed < 0 || landed > static_cast<double>(frame))
+        {
+            continue; // Landed past the cut (e.g. on the next keyframe): try from further back
+        }
+        for (size_t position = static_cast<size_t>(landed); position < frame; position++)
+        {
+            if (!cap.grab())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// Split the video into segments that are decoded and rendered at the same time, each from its own capture.
+// The first segment streams straight into the sink; the others are kept in temporary files until the ones
+// before them are written, then copied in. Frame numbers and times are counted from the start of the file,
+// so the segments join exactly where they were cut.
+bool exportVideo(const std::string &videoFile, const AsciiArtParams &params, const VideoOptions &options, FrameSink &sink)
+{
+    cv::VideoCapture cap(videoFile);
+    if (!cap.isOpened())
+    {
+        std::cerr << "Failed to open video/GIF file: " << videoFile << std::endl;
+        return false;
+    }
+
+    const bool auto_delay = options.frame_delay == VideoOptions::AUTO_DELAY;
+    const std::chrono::duration<double, std::milli> period_ms = framePeriod(cap, options);
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(period_ms);
+    const unsigned int workers = renderWorkerCount(options.render_workers, true);
+
+    // Segments need a frame count to cut at; short or unmeasured videos are exported in one piece
+    size_t segments = std::max<size_t>(options.segments, 1);
+    const double frame_count = cap.get(cv::CAP_PROP_FRAME_COUNT);
+    if (segments > 1 && !(frame_count >= static_cast<double>(segments * constants::VIDEO_MIN_SEGMENT_FRAMES)))
+    {
+        std::cerr << "Note: exporting in one segment (the video is too short or reports no frame count)" << std::endl;
+        segments = 1;
+    }
+    // Each segment needs a decode and a render slot of its own, within the in-flight limit
+    if (options.max_in_flight > 0 && segments > options.max_in_flight / 2)
+    {
+        segments = std::max<size_t>(options.max_in_flight / 2, 1);
+        std::cerr << "Note: exporting in " << segments << " segment" << (segments == 1 ? "" : "s")
+                  << " to stay within --max-in-flight " << options.max_in_flight << std::endl;
+    }
+    size_t total = segments > 1 ? static_cast<size_t>(frame_count) : 0;
+    auto first_frame = [&](size_t segment) { return total * segment / segments; };
+
+    auto start = Clock::now(); // Seeking counts toward the export time
+    // Open and position the later segments' captures up front: a file that can't be seeked close to a cut
+    // is exported in one piece rather than having every segment decode from the start
+    std::vector<std::unique_ptr<cv::VideoCapture>> segment_caps;
+    for (size_t s = 1; s < segments; s++)
+    {
+        auto segment_cap = std::make_unique<cv::VideoCapture>(videoFile);
+        if (!segment_cap->isOpened() || !seekToFrame(*segment_cap, first_frame(s)))
+        {
+            std::cerr << "Note: exporting in one segment (frame " << first_frame(s) << " of " << videoFile
+                      << " can't be reached without decoding from the start)" << std::endl;
+            segment_caps.clear();
+            segments = 1;
+            total = 0;
+            break;
+        }
+        segment_caps.push_back(std::move(segment_cap));
+    }
+
+    // Every segment gets its share of the render workers and of the in-flight limit
+    std::vector<ExportRun> runs(segments);
+    for (size_t s = 0; s < segments; s++)
+    {
+        runs[s].workers = std::max<unsigned int>(workers / static_cast<unsigned int>(segments), 1);
+        runs[s].max_in_flight = options.max_in_flight / segments; // At least 2 per segment after the check above
+        if (s + 1 < segments)
+        {
+            runs[s].frame_limit = first_frame(s + 1) - first_frame(s); // The last segment reads to the end
+        }
+    }
+
+    // --- Start the Later Segments ---
+    std::vector<std::unique_ptr<SegmentSpill>> spills;
+    try
+    {
+        for (size_t s = 1; s < segments; s++)
+        {
+            spills.push_back(std::make_unique<SegmentSpill>());
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+    std::vector<std::thread> segment_threads;
+    for (size_t s = 1; s < segments; s++)
+    {
+        segment_threads.emplace_back([&, s]() {
+            PresentationClock presentation(period, auto_delay);
+            presentation.startAt(first_frame(s));
+            exportFrames(*segment_caps[s - 1], params, presentation, *spills[s - 1], runs[s]);
+        });
+    }
+
+    // --- Write the Segments in Order ---
+    RebasedSink output(sink);
+    PresentationClock presentation(period, auto_delay);
+    if (segments > 1)
+    {
+        presentation.startAt(0); // Timed like the other segments
+    }
+    exportFrames(cap, params, presentation, output, runs[0]);
+    bool ok = runs[0].ok;
+    for (size_t s = 1; s < segments; s++)
+    {
+        segment_threads[s - 1].join();
+        if (ok && runs[s].ok)
+        {
+            try
+            {
+                spills[s - 1]->replay(output);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: " << e.what() << std::endl;
+                ok = false;
+            }
+        }
+        ok = ok && runs[s].ok;
+        spills[s - 1].reset(); // Frees its disk space
+    }
+    cap.release();
+    if (!ok)
+    {
+        return false;
+    }
+    try
+    {
+        output.finish(output.frames > 0 ? output.last_pts + period : Clock::duration(0));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+
+    // Throughput, to size conversion jobs: frames per second and how much faster than the video's own speed
+    unsigned int started_workers = 0;
+    size_t in_flight = 0;
+    for (const ExportRun &run : runs)
+    {
+        started_workers += run.started_workers;
+        in_flight += run.in_flight;
+    }
+    const size_t frames = output.frames;
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double video_seconds = frames > 0 ? std::chrono::duration<double>(output.last_pts + period).count() : 0.0;
+    std::cerr << std::fixed << std::setprecision(2) << "Exported " << frames << " frames in " << seconds << "s ("
+              << (seconds > 0 ? static_cast<double>(frames) / seconds : 0.0) << " fps, "
+              << (seconds > 0 ? video_seconds / seconds : 0.0) << "x real time) with " << started_workers
+              << " render worker" << (started_workers == 1 ? "" : "s");
+    if (segments > 1)
+    {
+        std::cerr << " in " << segments << " segments";
+    }
+    std::cerr << ", up to " << in_flight << " frames in flight" << std::endl;
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ascii_art.h"
+#include "image.h"
+#include <string>
+#include <opencv2/opencv.hpp>
+
+// Playback settings for videos and animated GIFs
+struct VideoOptions
+{
+    static constexpr int AUTO_DELAY = -1; // frame_delay value that follows the file's own timing
+    static constexpr double AUTO_RENDER_BUDGET = -1.0; // render_budget_ms value that keeps up with the frame rate
+
+    int frame_delay = AUTO_DELAY;    // Delay between frames in milliseconds, or AUTO_DELAY
+    bool show_stats = false;         // Print per-stage timings, latency and queue depths when done
+    unsigned int render_workers = 0; // Render threads (0 picks from the hardware concurrency)
+    bool drop_late_frames = true;    // Skip frames that missed their deadline (false plays every frame, late if need be)
+    bool verify_output = false;      // Replay the bytes sent to the terminal into a virtual screen and check every frame
+    size_t max_bytes_per_sec = 0;    // Output budget: lower the quality when frames take more (0 = no limit)
+    double render_budget_ms = 0.0;   // Resize and render time per frame: lower the quality when frames take longer
+                                     // (0 = no budget, AUTO_RENDER_BUDGET = the frame period times the render workers)
+    double start_seconds = 0.0;      // Start recorded ASCII video playback this far in
+    size_t max_in_flight = 0;        // Most frames decoded or rendered ahead at once, across all render workers
+                                     // (bounds memory; 0 = a few per worker)
+    size_t segments = 1;             // Export only: split the video into this many parts, decoded and rendered at once
+};
+
+// --- Function Declarations ---
+
+// Play a video/GIF in the terminal using the ASCII art pipeline
+// Frames are decoded, rendered and written on separate threads connected by bounded ring buffers,
+// so a slow decode or render doesn't stall the display. Frames are paced against wall-clock deadlines;
+// late frames are dropped (and counted) unless options.drop_late_frames is off. Only the cells that
+// changed since the previous frame are sent to the terminal. With a byte budget, a quality ladder
+// trades color, grid size and update rate for bandwidth; with a render budget, another one trades the
+// edge pass, resize filter, color and grid size for render time.
+// videoFile: Path to video/GIF
+// params: ASCII art parameters (same as used for static images)
+// options: Playback settings
+// Returns: true if processing successful, false otherwise
+bool processVideo(const std::string &videoFile, const AsciiArtParams &params, const VideoOptions &options);
+
+// Render a video/GIF into a sink instead of the terminal: the same decode thread and render workers, but no
+// pacing, no dropped frames and no terminal control sequences, so it runs as fast as decoding and rendering allow.
+// videoFile: Path to video/GIF
+// params: ASCII art parameters (auto-fit uses the terminal size, or the default size without a terminal)
+// With options.segments above 1, the video is cut into that many parts at exact frame numbers, each decoded
+// from its own capture at the same time, and the parts are joined in order.
+// options: Frame timing, render workers and segments (pacing and quality options don't apply)
+// sink: Receives every frame in order
+// Returns: true if every frame was exported, false otherwise (an error is printed)
+bool exportVideo(const std::string &videoFile, const AsciiArtParams &params, const VideoOptions &options, FrameSink &sink);
+
+// Check if file is a supported video/GIF format
+// filename: Input file path to check
+// Returns: true if file extension matches supported video/GIF formats, false otherwise
+bool isVideoFile(const std::string &filename);
+
+// View an OpenCV Mat for the existing pipeline without copying its pixels
+// mat: OpenCV Mat object containing frame data (any row step)
+// Returns: A BGR-tagged view that shares (and keeps alive) the Mat's buffer; no conversion pass is made.
+//          The decoder may reuse the buffer for the next frame, so don't keep the view across reads.
+ImageView matToImageView(const cv::Mat &mat);
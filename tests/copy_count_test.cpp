@@ -0,0 +1,95 @@
+#include "ascii_art.h"
+#include "image.h"
+#include "video.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Counts the pixel bytes copied while rendering one frame from each kind of source the pipeline takes
+// (decoded images, crops, OpenCV video frames) in each resize mode. Frames are meant to flow from the
+// decoder to the renderer as views, so every count has to be zero.
+
+// Render one frame and return the pixel bytes copied on the way (-1 if rendering failed)
+static int64_t bytesCopiedRendering(const ImageView &view, const AsciiArtParams &params)
+{
+    std::string ascii_text;
+    std::string error;
+    const uint64_t before = imageBytesCopied();
+    if (!renderImage(view, params, ascii_text, error) || ascii_text.empty())
+    {
+        return -1;
+    }
+    return static_cast<int64_t>(imageBytesCopied() - before);
+}
+
+// Print the count for one case; returns true if nothing was copied
+static bool expectNoCopies(const std::string &name, const ImageView &view, const AsciiArtParams &params)
+{
+    const int64_t copied = bytesCopiedRendering(view, params);
+    std::cout << name << ": " << copied << " bytes copied per frame" << std::endl;
+    return copied == 0;
+}
+
+int main()
+{
+    bool ok = true;
+
+    // A decoded image: 4-channel gradient
+    Image img;
+    img.width = 120;
+    img.height = 80;
+    img.channels = 4;
+    img.data.resize(static_cast<size_t>(img.width) * img.height * img.channels);
+    for (size_t i = 0; i < img.data.size(); i++)
+    {
+        img.data[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    // The counter itself has to see copies
+    const uint64_t before = imageBytesCopied();
+    Image copy = copyImage(img);
+    if (imageBytesCopied() - before != img.data.size())
+    {
+        std::cout << "copyImage: copy not counted" << std::endl;
+        ok = false;
+    }
+
+    // Without auto-fit the terminal resize hands back the same pixels
+    const uint64_t before_resize = imageBytesCopied();
+    ImageView unresized = resizeImageToTerminal(img, 2.0f, false);
+    std::cout << "resizeImageToTerminal without auto-fit: " << imageBytesCopied() - before_resize
+              << " bytes copied" << std::endl;
+    ok = ok && unresized.data == img.data.data() && imageBytesCopied() == before_resize;
+
+    AsciiArtParams fit; // Auto-fit to the terminal (80x24 when there is none)
+    AsciiArtParams original;
+    original.auto_fit = false;
+    AsciiArtParams scaled = original;
+    scaled.scale = 0.5f;
+    AsciiArtParams color_edges = fit;
+    color_edges.color = true;
+    color_edges.detect_edges = true;
+
+    ok = expectNoCopies("image, auto-fit", img, fit) && ok;
+    ok = expectNoCopies("image, original size", img, original) && ok;
+    ok = expectNoCopies("image, scaled", img, scaled) && ok;
+    ok = expectNoCopies("image, color and edges", img, color_edges) && ok;
+    ok = expectNoCopies("crop, original size", ImageView(img).crop(10, 10, 60, 40), original) && ok;
+    ok = expectNoCopies("crop, auto-fit", ImageView(img).crop(10, 10, 60, 40), fit) && ok;
+
+    // A video frame as OpenCV delivers it (BGR)
+    cv::Mat frame(90, 160, CV_8UC3);
+    for (int y = 0; y < frame.rows; y++)
+    {
+        uint8_t *row = frame.ptr<uint8_t>(y);
+        for (int x = 0; x < frame.cols * 3; x++)
+        {
+            row[x] = static_cast<uint8_t>(x + y * 3);
+        }
+    }
+    ok = expectNoCopies("video frame, auto-fit", matToImageView(frame), fit) && ok;
+    ok = expectNoCopies("video frame, original size", matToImageView(frame), original) && ok;
+    ok = expectNoCopies("video frame, color and edges", matToImageView(frame), color_edges) && ok;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Write a short synthetic video for the export tests: a bright disc moving across a scrolling gradient,
+// so every frame differs from the one before and color, edges and deltas all get exercised.
+// Usage: make_test_clip <output.avi> <frames> <width> <height>
+// Uses OpenCV's built-in Motion JPEG writer, which needs no external codec.
+int main(int argc, char *argv[])
+{
+    if (argc != 5)
+    {
+        std::cerr << "Usage: " << argv[0] << " <output.avi> <frames> <width> <height>" << std::endl;
+        return 1;
+    }
+    const std::string path = argv[1];
+    const int frames = std::stoi(argv[2]);
+    const int width = std::stoi(argv[3]);
+    const int height = std::stoi(argv[4]);
+
+    cv::VideoWriter writer(path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30.0, cv::Size(width, height));
+    if (!writer.isOpened())
+    {
+        std::cerr << "Error: Failed to create test clip: " << path << std::endl;
+        return 1;
+    }
+
+    cv::Mat frame(height, width, CV_8UC3);
+    for (int f = 0; f < frames; f++)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            uint8_t *row = frame.ptr<uint8_t>(y);
+            for (int x = 0; x < width; x++)
+            {
+                const int dx = x - width / 4 - f * 2;
+                const int dy = y - height / 2;
+                const bool disc = dx * dx + dy * dy < height * height / 9;
+                const uint8_t value = disc ? 220 : static_cast<uint8_t>(((x + f) * 4) & 0xff);
+                // OpenCV frames are BGR
+                row[x * 3 + 0] = value;
+                row[x * 3 + 1] = static_cast<uint8_t>(value / 2);
+                row[x * 3 + 2] = static_cast<uint8_t>(y * 255 / height);
+            }
+        }
+        writer.write(frame);
+    }
+    writer.release();
+    return 0;
+}
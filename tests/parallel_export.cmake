@@ -0,0 +1,39 @@
+# Check that parallel video rendering produces exactly the output of serial rendering.
+# Exports one synthetic clip with a single render worker, then with several workers under a tight
+# --max-in-flight bound, and compares the files byte for byte.
+# Run by CTest with: -DPIXCII=<pixcii> -DMAKE_CLIP=<make_test_clip> -DWORK_DIR=<scratch directory>
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+# The name also describes the clip (width x height, frame count)
+set(CLIP "${WORK_DIR}/synth_96x54_60.avi")
+execute_process(COMMAND "${MAKE_CLIP}" "${CLIP}" 60 96 54 RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Failed to create the test clip")
+endif()
+
+# Export the clip with the given extra arguments, at its own size so the output doesn't depend on a terminal
+function(export_clip output)
+    execute_process(COMMAND "${PIXCII}" -i "${CLIP}" -g -c -o "${output}" ${ARGN}
+                    RESULT_VARIABLE result ERROR_VARIABLE errors)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "pixcii ${ARGN} failed: ${errors}")
+    endif()
+endfunction()
+
+# Text frames and a recorded .pxv video (which also stores the frame times)
+foreach(extension txt pxv)
+    export_clip("${WORK_DIR}/serial.${extension}" -j 1)
+    foreach(variant "4;--max-in-flight;3" "4")
+        string(REPLACE ";" "_" name "${variant}")
+        string(REPLACE ";" " " arguments "${variant}")
+        export_clip("${WORK_DIR}/parallel_${name}.${extension}" -j ${variant})
+        execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files
+                                "${WORK_DIR}/serial.${extension}" "${WORK_DIR}/parallel_${name}.${extension}"
+                        RESULT_VARIABLE result)
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "-j ${arguments} output differs from -j 1 output (.${extension})")
+        endif()
+    endforeach()
+endforeach()